@@ -29,6 +29,7 @@
  */
 
 #include "ISBD.h"
+#include <stddef.h>
 
 
 ISBD::ISBD(Stream &iridium_stream, Stream &console_stream, int modem_power_pin, int modem_sleep_pin)
@@ -46,23 +47,55 @@ ISBD::~ISBD()
 }
 
 
-bool ISBD::getNetworkStatus()
+bool ISBD::getNetworkStatus(const unsigned long timeout_ms, ISBDCancelToken *cancel_token)
 {
         #ifdef ISBD_CONSOLE        
                 console(F("CHECKING NETWORK SERVICE\n"));
         #endif
-        if (enableModem() != ISBD_SUCCESS) return ISBD_ERR_NO_MODEM_DETECTED;
-        return checkNetworkService();
+        beginOperation(timeout_ms, cancel_token);
+        bool found_network_service = false;
+        if (enableModem() == ISBD_SUCCESS) found_network_service = checkNetworkService();
+        endOperation(found_network_service ? ISBD_SUCCESS : ISBD_ERR_NOT_SPECIFIED);
+        return found_network_service;
+}
+
+
+int ISBD::sendTextMsg(String& msg_out, const bool is_urgent, const unsigned long timeout_ms, ISBDCancelToken *cancel_token)
+{
+        beginOperation(timeout_ms, cancel_token);
+        return endOperation(sendTextMsgImpl(msg_out, is_urgent));
+}
+
+
+int ISBD::sendReceiveTxtMsg(String& msg_out, String& msg_in, int& num_msg_in, const unsigned long timeout_ms, ISBDCancelToken *cancel_token)
+{
+        beginOperation(timeout_ms, cancel_token);
+        return endOperation(sendReceiveTxtMsgImpl(msg_out, msg_in, num_msg_in));
+}
+
+
+int ISBD::sendBinaryMsg(const uint8_t *tx_data, size_t tx_buffer_size, const bool is_urgent, const unsigned long timeout_ms, ISBDCancelToken *cancel_token)
+{
+        beginOperation(timeout_ms, cancel_token);
+        return endOperation(sendBinaryMsgImpl(tx_data, tx_buffer_size, is_urgent));
+}
+
+
+int ISBD::receiveMsgs(const unsigned long timeout_ms, ISBDCancelToken *cancel_token)
+{
+        beginOperation(timeout_ms, cancel_token);
+        return endOperation(receiveMsgsImpl());
 }
 
 
-int ISBD::sendTextMsg(String& msg_out)
+int ISBD::sendTextMsgImpl(String& msg_out, const bool is_urgent)
 {
         #ifdef ISBD_CONSOLE        
                 console(F("SENDING TXT MSG\n"));
         #endif
         gMTqueued_ = 99;
         if (msg_out.length() <= 0)                              return ISBD_ERR_MSG_SIZE;
+        if (!is_urgent && getNextTransmitWindowSec() > 0)       return ISBD_ERR_POSTPONED;
         if (enableModem() != ISBD_SUCCESS)                      return ISBD_ERR_NO_MODEM_DETECTED;
         flushSerialRxBuffer();            
         bool success = getSbdStatus(); 
@@ -74,12 +107,13 @@ int ISBD::sendTextMsg(String& msg_out)
         if (!success)                                           return ISBD_ERR_GET_STATUS; 
         if (!uploadTxtMsgToModem(msg_out))                      return ISBD_ERR_UPLOAD_TO_MODEM;
         if (!connectToSatellites(transmissionTimeoutSec_))      return ISBD_ERR_SENDRECEIVE_TIMEOUT;
+        if (gMTBuffer_ == 1 && numMsgHandlers_ > 0)             dispatchIncomingMsg();                  // Downlink came with this session
         if (gMOBuffer_ == 2)                                    return ISBD_ERR_NOT_SPECIFIED;          // gMOBuffer_ should be ether 0 or 1
         return ISBD_SUCCESS;
 }
 
 
-int ISBD::sendReceiveTxtMsg(String& msg_out, String& msg_in, int& num_msg_in)
+int ISBD::sendReceiveTxtMsgImpl(String& msg_out, String& msg_in, int& num_msg_in)
 {
         #ifdef ISBD_CONSOLE
                 console(F("SENDING/RECEIVING TXT MSG\n"));
@@ -100,7 +134,7 @@ int ISBD::sendReceiveTxtMsg(String& msg_out, String& msg_in, int& num_msg_in)
         if (!uploadTxtMsgToModem(msg_out))      return ISBD_ERR_UPLOAD_TO_MODEM;
         do {                                    //We are only using the latest incoming message
                 success = connectToSatellites(transmissionTimeoutSec_);
-        } while (gMTqueued_);
+        } while (gMTqueued_ && !isOperationAborted());
         if (!success)                           return ISBD_ERR_SENDRECEIVE_TIMEOUT;
         msg_in     = "";
         num_msg_in = 0;
@@ -111,12 +145,13 @@ int ISBD::sendReceiveTxtMsg(String& msg_out, String& msg_in, int& num_msg_in)
 }
 
 
-int ISBD::sendBinaryMsg(const uint8_t *tx_data, size_t tx_buffer_size)
+int ISBD::sendBinaryMsgImpl(const uint8_t *tx_data, size_t tx_buffer_size, const bool is_urgent)
 {
         #ifdef ISBD_CONSOLE
                 console(F("SENDING BINARY MSG\n"));
         #endif 
         if (tx_buffer_size <= 0)                                return ISBD_ERR_MSG_SIZE;        
+        if (!is_urgent && getNextTransmitWindowSec() > 0)       return ISBD_ERR_POSTPONED;
         if (enableModem() != ISBD_SUCCESS)                      return ISBD_ERR_NO_MODEM_DETECTED;
         flushSerialRxBuffer();
         gMOBuffer_ = 0;                        
@@ -129,11 +164,28 @@ int ISBD::sendBinaryMsg(const uint8_t *tx_data, size_t tx_buffer_size)
         if (!success)                                           return ISBD_ERR_GET_STATUS; 
         if (!uploadBinaryMsgToModem(tx_data,tx_buffer_size))    return ISBD_ERR_UPLOAD_TO_MODEM;
         if (!connectToSatellites(transmissionTimeoutSec_))      return ISBD_ERR_SENDRECEIVE_TIMEOUT;
+        if (gMTBuffer_ == 1 && numMsgHandlers_ > 0)             dispatchIncomingMsg();                  // Downlink came with this session
         if (gMOBuffer_==2)                                      return ISBD_ERR_NOT_SPECIFIED;          // gMOBuffer_ should be ether 0 or 1
         return ISBD_SUCCESS;
 }
 
 
+int ISBD::receiveMsgsImpl()
+{
+        #ifdef ISBD_CONSOLE
+                console(F("CHECKING MAILBOX\n"));
+        #endif 
+        if (enableModem() != ISBD_SUCCESS)                      return ISBD_ERR_NO_MODEM_DETECTED;
+        flushSerialRxBuffer();
+        if (clearMOBuffer() != ISBD_SUCCESS)                    return ISBD_ERR_CLEAR_MODEM_BUFFER;     // Mailbox check without MO msg
+        do {
+                if (!connectToSatellites(transmissionTimeoutSec_)) return ISBD_ERR_SENDRECEIVE_TIMEOUT;
+                if (gMTBuffer_ == 1) dispatchIncomingMsg();
+        } while (gMTqueued_ > 0 && !isOperationAborted());
+        return ISBD_SUCCESS;
+}
+
+
 int sendReceiveBinaryMsg(const uint8_t *tx_data, size_t tx_data_size, uint8_t *rx_Buffer, size_t &rx_buffer_size)
 {
         // TODO: Implement
@@ -189,6 +241,7 @@ bool ISBD::checkNetworkService()
                         #endif 
                         return false;
                 }
+                if ( !found_network_service && isOperationAborted() ) return false;
         }
         return true;
 }
@@ -228,6 +281,7 @@ bool ISBD::setIsConsolePrint(const bool is_console_print)
                 return true;
         #endif 
         
+        (void)is_console_print;
         return false;   // Console not compiled 
 }
 
@@ -244,6 +298,158 @@ void ISBD::setLowPowerUpTimeSec(int low_power_up_time_sec)
 }
 
 
+int ISBD::getTransmissionTimeoutSec()
+{
+        return transmissionTimeoutSec_;
+}
+
+void ISBD::setTransmissionTimeoutSec(int transmission_timeout_sec)
+{
+        transmissionTimeoutSec_ = transmission_timeout_sec;
+}
+
+
+bool ISBD::getIsFlowControl()
+{
+        return isFlowControl_;
+}
+
+bool ISBD::setIsFlowControl(const bool is_flow_control)
+{
+        isFlowControl_ = is_flow_control;
+        if (!modemIsEnabled_) return true;      // Applied on next power up
+        return sendFlowControlToModem();
+}
+
+
+long ISBD::getBaudRate()
+{
+        return baudRate_;
+}
+
+int ISBD::setBaudRate(const long baud_rate)
+{
+        if (getIprCode(baud_rate) < 0)                                  return ISBD_ERR_BAUDRATE;
+        if (baud_rate != ISBD_SERIAL_BAUDRATE && !setHostBaudRate_)     return ISBD_ERR_BAUDRATE;      // Host port can not follow
+        baudRate_ = baud_rate;
+        if (!modemIsEnabled_)                                           return ISBD_SUCCESS;            // Applied on next power up
+        if (switchModemBaudRate(baud_rate))                             return ISBD_SUCCESS;
+        if (!modemPowerUp()) {                                                                          // Modem was power cycled
+                enableSleep();
+                waitMs(100);                    // Wait for serial to be turned off
+                disableModemPower();
+                modemIsEnabled_ = false;
+        }
+        return ISBD_ERR_BAUDRATE;
+}
+
+void ISBD::setHostBaudRateFunction(void (*set_host_baud_rate)(long baud_rate))
+{
+        setHostBaudRate_ = set_host_baud_rate;
+}
+
+
+/**
+ * Set message handler 
+ * 
+ * Registers handler for incoming binary messages starting with opcode. 
+ * A NULL handler removes the opcode. Returns false if all 
+ * ISBD_MAX_MSG_HANDLERS are taken.
+ */
+bool ISBD::setMsgHandler(const uint8_t opcode, ISBDMsgHandler handler)
+{
+        for (int i=0; i<numMsgHandlers_; ++i) {
+                if (msgHandlers_[i].opcode != opcode) continue;
+                if (handler) {
+                        msgHandlers_[i].handler = handler;
+                } else {
+                        msgHandlers_[i] = msgHandlers_[--numMsgHandlers_];
+                }
+                return true;
+        }
+        if (!handler)                                   return true;
+        if (numMsgHandlers_ >= ISBD_MAX_MSG_HANDLERS)   return false;
+        msgHandlers_[numMsgHandlers_].opcode  = opcode;
+        msgHandlers_[numMsgHandlers_].handler = handler;
+        numMsgHandlers_++;
+        return true;
+}
+
+unsigned int ISBD::getNumUnknownMsgs()
+{
+        return numUnknownMsgs_;
+}
+
+unsigned int ISBD::getNumMalformedMsgs()
+{
+        return numMalformedMsgs_;
+}
+
+
+void ISBD::setTimeFunction(unsigned long (*get_time_sec)())
+{
+        getTimeSec_ = get_time_sec;
+}
+
+
+/**
+ * Get next transmit window
+ * 
+ * Returns the seconds until the next time slot whose success rate in the 
+ * session history is within ISBD_HISTORY_WINDOW_MARGIN_PCT of the best slot. 
+ * Returns 0 if we are in such a slot now.
+ */
+long ISBD::getNextTransmitWindowSec()
+{
+        const unsigned long now_sec  = getTimeSec();
+        const int           now_slot = (now_sec / ISBD_HISTORY_SLOT_SEC) % ISBD_HISTORY_NUM_SLOTS;
+        int best_pct = 0;
+        for (int slot=0; slot<ISBD_HISTORY_NUM_SLOTS; ++slot) {
+                const int pct = getSlotSuccessPct(slot);
+                if (pct > best_pct) best_pct = pct;
+        }
+        for (int i=0; i<ISBD_HISTORY_NUM_SLOTS; ++i) {
+                if (getSlotSuccessPct((now_slot+i) % ISBD_HISTORY_NUM_SLOTS) + ISBD_HISTORY_WINDOW_MARGIN_PCT >= best_pct) {
+                        if (i == 0) return 0;
+                        return (long)i*ISBD_HISTORY_SLOT_SEC - (long)(now_sec % ISBD_HISTORY_SLOT_SEC);
+                }
+        }
+        return 0;
+}
+
+
+size_t ISBD::exportSessionHistory(uint8_t *buffer, const size_t buffer_size)
+{
+        if (buffer_size < sizeof(history_)) return 0;
+        memcpy(buffer, &history_, sizeof(history_));
+        return sizeof(history_);
+}
+
+
+bool ISBD::importSessionHistory(const uint8_t *buffer, const size_t buffer_size)
+{
+        if (buffer_size != sizeof(history_)) return false;
+        if (buffer[offsetof(ISBDSessionHistory, next)]  >= ISBD_HISTORY_SIZE) return false;     // Check in place, no copy on stack
+        if (buffer[offsetof(ISBDSessionHistory, count)] >  ISBD_HISTORY_SIZE) return false;
+        memcpy(&history_, buffer, sizeof(history_));
+        return true;
+}
+
+
+void ISBD::printSessionHistory(Stream &stream)
+{
+        stream.print(F("time_sec,signal,mo_status,mt_status,duration_ds\n"));
+        for (int i=0; i<history_.count; ++i) {                                  // Oldest first
+                const ISBDSession& session = history_.sessions[(history_.next + ISBD_HISTORY_SIZE - history_.count + i) % ISBD_HISTORY_SIZE];
+                stream.print(String(session.time_sec) + "," + String(session.signal) + "," + String(session.mo_status) + "," + String(session.mt_status) + "," + String(session.duration_ds) + "\n");
+        }
+        stream.print(F("slot,attempts,successes\n"));
+        for (int slot=0; slot<ISBD_HISTORY_NUM_SLOTS; ++slot) {
+                stream.print(String(slot) + "," + String(history_.slot_attempts[slot]) + "," + String(history_.slot_successes[slot]) + "\n");
+        }
+}
+
+
 
 
 
@@ -275,21 +481,19 @@ bool ISBD::uploadBinaryMsgToModem(const uint8_t *tx_data, size_t tx_data_size)
         if (tx_data_size > ISBD_BIN_MAX_TX_MSG_SIZE) {
                 tx_data_size = ISBD_BIN_MAX_TX_MSG_SIZE;
         } 
-        delay(200);
+        flushSerialRxBuffer();
         sendToModem(F("AT+SBDWB="));                            //Sending binary mode
-        sendToModem(String(tx_data_size ,DEC));                 //Msg buffersize  // TODO: This was console.print before (instead of write), does it work? @test
+        sendToModem(String(tx_data_size ,DEC));                 //Msg buffersize
         sendToModem("\r"); 
-        delay(200);
+        if (!waitForModemResponse(10, F("READY\r\n"))) return false;    //Modem is ready to take the data
         uint16_t checksum = 0;
         for (unsigned int i=0; i<tx_data_size; ++i) {
-                iridiumStream_->write(tx_data[i]);              //Transfering byte by byte
                 checksum += (uint16_t)tx_data[i];
         }
+        iridiumStream_->write(tx_data, tx_data_size);           //Transfering message in one block
         iridiumStream_->write(checksum >> 8);                   //Highbyte 
         iridiumStream_->write(checksum & 0xFF);                 //Lowbyte
-        delay(200);
         bool success = false; 
-        success = waitForModemResponse(60, F("READY\r\n"));  
         success = waitForModemResponse(60, F("0\r\n\r\nOK\r\n")); 
         success = getSbdStatus();
         if (!success) {
@@ -310,16 +514,21 @@ bool ISBD::waitForModemResponse(long timeout_sec, String ending, String& respons
                 console(F("From Modem: "));                                         
         #endif 
         response = "";
+        response.reserve(ISBD_RESPONSE_BUFFER_SIZE);    //Allocate once, response never grows beyond
         const unsigned long start_time_ms = millis();   //RTC does not work here, possibly signal distortion when communicating with Iridium modem leads to wrong readings 
+        const unsigned long timeout_ms    = getRemainingMs(timeout_sec*1000);
         while (!strS1EndsWithS2(response, ending)) {
                 if (iridiumStream_->available()) {
                         char c   = iridiumStream_->read(); 
-                        response += String(c);
+                        if (response.length() >= ISBD_RESPONSE_BUFFER_SIZE) {
+                                response.remove(0, ISBD_RESPONSE_BUFFER_SIZE/2);   //Drop oldest half, result code is at the end
+                        }
+                        response += c;
                         #ifdef ISBD_CONSOLE
                                 consoleHeaderless(String(c));                                         
                         #endif 
                 } 
-                if (millis() >= (start_time_ms+(timeout_sec*1000))) {
+                if (millis() - start_time_ms >= timeout_ms || isOperationAborted()) {
                         return false;
                 }
         }
@@ -367,8 +576,15 @@ bool ISBD::connectToSatellites(const long timeout_sec)
         unsigned long start_time_ms = millis();
         String response = "";
         do {    // repeat until no error or timeout
+                const int           signal           = getSignalQuality();
+                if (isOperationAborted()) return false;                 // Do not start a session that can not be waited for
+                const unsigned long attempt_time_sec = getTimeSec();
+                const unsigned long attempt_start_ms = millis();
                 sendToModem("AT+SBDI\r");
-                if(!waitForModemResponse(60, F("OK\r\n"), response)) return false; 
+                if(!waitForModemResponse(60, F("OK\r\n"), response)) {
+                        if (!isOperationAborted()) addSessionToHistory(attempt_time_sec, signal, 2, 2, millis()-attempt_start_ms);
+                        return false; 
+                }
 
                 int index_1 = response.indexOf(':'); 
                 int index_2 = response.indexOf(',');
@@ -386,6 +602,7 @@ bool ISBD::connectToSatellites(const long timeout_sec)
                 index_1     = index_2;     
                 index_2     = response.indexOf(',',index_1+1);
                 gMTqueued_  = response.substring(index_1+1,index_2).toInt();
+                addSessionToHistory(attempt_time_sec, signal, gMOBuffer_, gMTBuffer_, millis()-attempt_start_ms);
                 
                 if( millis() > (start_time_ms+(timeout_sec*1000)) ) {
                         #ifdef ISBD_CONSOLE
@@ -394,7 +611,7 @@ bool ISBD::connectToSatellites(const long timeout_sec)
                         return false;
                 }
                 
-                if(consoleStream_->read() == 'c') {    
+                if(consoleStream_->read() == 'c' || isOperationAborted()) {    
                         #ifdef ISBD_CONSOLE
                                 console(F("Canceled\n"));
                         #endif  
@@ -402,7 +619,7 @@ bool ISBD::connectToSatellites(const long timeout_sec)
                         gMTBuffer_ = 0;                  // Reset on cancel
                         return false;
                 }
-        } while (gMOBuffer_==2);
+        } while (gMOBuffer_==2 || (gMOBuffer_==0 && gMTBuffer_==2));   // MO status 0: no msg to send, MT status tells if the session failed
         #ifdef ISBD_CONSOLE
                 console(F("Success\n"));
         #endif 
@@ -415,66 +632,100 @@ bool ISBD::connectToSatellites(const long timeout_sec)
 
 
 bool ISBD::getIncomingTxtMsgFromModem(String& msg)
+{  
+        size_t msg_size = 0;
+        msg = "";
+        if (!getIncomingMsgFromModem(msg_size)) return false;
+        msg.reserve(msg_size);
+        for (size_t i=0; i<msg_size; ++i) {
+                msg += (char)mtBuffer_[i];
+        }
+        return true;
+}
+
+
+/**
+ * Get incoming message from modem 
+ * 
+ * Reads the MT buffer of the modem (AT+SBDRB) into mtBuffer_ and clears it
+ * on success. Messages larger than mtBuffer_ are read and dropped. 
+ * Modem sends: size[2], body[size], checksum[2], OK
+ */
+bool ISBD::getIncomingMsgFromModem(size_t& msg_size)
 {  
         #ifdef ISBD_CONSOLE
                 console(F("Downloading incoming msg\n"));
         #endif 
-        
+        msg_size = 0;
         sendToModem(F("AT+SBDRB\r"));            //Get message from modem 
 
         unsigned long start_time_ms = millis();     //Millis should be removed in a later version, but is works here
         while (iridiumStream_->available() < 2) {
-                if (millis() > start_time_ms+15000UL) {
-                        break;
+                if (millis() > start_time_ms+15000UL || isOperationAborted()) {
+                        return false;
                 }
         }
+        uint16_t rx_size   = (uint16_t)iridiumStream_->read() << 8;    //Incoming message size
+        rx_size           |= (uint16_t)iridiumStream_->read();
 
-        //Read incoming data as: rxSize[2], body[rxsSize], checksum[2]
-        uint16_t rx_size = 256 * iridiumStream_->read() + iridiumStream_->read(); //Incoming message size
-        if(rx_size > ISBD_TXT_MAX_RX_MSG_SIZE){rx_size = ISBD_TXT_MAX_RX_MSG_SIZE;}      //Limit incoming size.
-
-        uint16_t checksum  = 0;
+        uint16_t checksum   = 0;
         uint16_t bytes_read = 0;
-        uint8_t  rx_buffer [(size_t)rx_size];
-        char     input [(size_t)rx_size]; 
-
         start_time_ms = millis();
         while (bytes_read < rx_size) {
                 if ( iridiumStream_->available() ) {
-                        uint8_t t_ui8In       = iridiumStream_->read();
-                        rx_buffer[bytes_read] = t_ui8In;
-                        checksum             += (uint16_t)t_ui8In;
+                        const uint8_t c = iridiumStream_->read();
+                        if (bytes_read < sizeof(mtBuffer_)) mtBuffer_[bytes_read] = c;
+                        checksum += (uint16_t)c;
                         bytes_read++; 
                 }
-                if ( millis()>(start_time_ms+30000UL) ) {
-                        break;
+                if ( millis()>(start_time_ms+30000UL) || isOperationAborted() ) {
+                        return false;
                 }
         }
   
         start_time_ms = millis();
         while (iridiumStream_->available() < 2) {
-                if ( millis()>start_time_ms+15000UL ) {
-                        break;
+                if ( millis()>start_time_ms+15000UL || isOperationAborted() ) {
+                        return false;
                 }
         }
+        uint16_t checksum_modem  = (uint16_t)iridiumStream_->read() << 8;
+        checksum_modem          |= (uint16_t)iridiumStream_->read();
+        waitForModemResponse(10, F("OK\r\n"));                         // Consume result code of AT+SBDRB
 
-        uint16_t checksumModem = 256 * iridiumStream_->read() + iridiumStream_->read();
+        if (checksum_modem != checksum || rx_size > sizeof(mtBuffer_)) return false;
+        msg_size = rx_size;
+        clearMTBuffer();                // Clear incoming buffer!
+        return true;
+}
 
-        delay(10);
-        msg = "";
-        if(checksumModem == checksum) {
-                for (int i=0; i<rx_size; ++i) {
-                        input[i] = (char)rx_buffer[i];
-                        msg     += (String)input[i];  
-                }
-                // delay(5);                              // TODO: needed?
-        }
-        else {
+
+/**
+ * Dispatch incoming message 
+ * 
+ * Downloads the MT message and hands it to the handler registered for its 
+ * first byte (opcode). The handler gets a view into mtBuffer_, valid until
+ * it returns.
+ */
+bool ISBD::dispatchIncomingMsg()
+{
+        size_t msg_size = 0;
+        if (!getIncomingMsgFromModem(msg_size) || msg_size == 0) {
+                if (!isOperationAborted()) numMalformedMsgs_++;
                 return false;
         }
-
-        clearMTBuffer();                // Clear incoming buffer!
-        return true;
+        const uint8_t opcode = mtBuffer_[0];
+        for (int i=0; i<numMsgHandlers_; ++i) {
+                if (msgHandlers_[i].opcode == opcode) {
+                        msgHandlers_[i].handler(mtBuffer_+1, msg_size-1);
+                        return true;
+                }
+        }
+        #ifdef ISBD_CONSOLE
+                console(F("No handler for opcode "), String(opcode), F("\n"));
+        #endif 
+        numUnknownMsgs_++;
+        return false;
 }
 
 
@@ -541,36 +792,55 @@ void ISBD::disableModemPower()
 
 bool ISBD::modemPowerUp()
 {
-        #ifdef ISBD_CONSOLE
-                console(F("Power up\n"));
-        #endif 
-        enableModemPower();
-        delay(1000);                                                    // wait for power up
-        disableSleep();
-        delay(1000);                                                    // wait for wake up // TODO: Is this enough?
-        if(!getSbdAttention()) return false;   
-        sendToModem(F("Z0\r"));                                         // SoftReset
-        sendToModem(F("ATE0\r"));                                       // Turn off Echo
-        sendToModem(F("AT&K0\r"));                                      // Disable RTS/CTS flow control for 3-wire mode
-        if ( !waitForModemResponse(10, F("OK\r\n")) ) return false;  
-        return true;
+        for (int attempt=0; attempt<2; ++attempt) {                     // Second attempt with the default baudrate after a failed switch
+                #ifdef ISBD_CONSOLE
+                        console(F("Power up\n"));
+                #endif 
+                if (linkBaudRate_ != ISBD_SERIAL_BAUDRATE) {
+                        setLinkBaudRate(ISBD_SERIAL_BAUDRATE);          // Modem always powers up with the default baudrate
+                }
+                enableModemPower();
+                if (!waitMs(1000)) return false;                        // wait for power up
+                disableSleep();
+                if (!waitMs(1000)) return false;                        // wait for wake up // TODO: Is this enough?
+                flushSerialRxBuffer();                                  // Drop answers to commands sent before the power cycle
+                if(!getSbdAttention()) return false;   
+                sendToModem(F("ATZ0\r"));                               // SoftReset
+                if (!waitForModemResponse(10, F("OK\r\n"))) return false;
+                sendToModem(F("ATE0\r"));                               // Turn off Echo
+                if (!waitForModemResponse(10, F("OK\r\n"))) return false;
+                if (!sendFlowControlToModem()) return false;
+                if (switchModemBaudRate(baudRate_)) return true;        // baudRate_ is the default after a failed switch
+        }
+        return false;
 }
 
 
-void ISBD::modemPowerDown()
+void ISBD::modemPowerDown(const long flush_timeout_sec)
 {
         #ifdef ISBD_CONSOLE
                 console(F("Power down\n"));        
         #endif 
-        sendToModem(F("AT*F\r"));               // Flushs pending writes to EEPROM and waits for completion before shut-down
-        waitForModemResponse(20, F("OK\r\n"));  // Wait for response before shut-down
+        flushSerialRxBuffer();                                  // Drop answers to aborted commands, they would end the wait below
+        sendToModem(F("AT*F\r"));                               // Flushs pending writes to EEPROM and waits for completion before shut-down
+        waitForModemResponse(flush_timeout_sec, F("OK\r\n"));  // Wait for response before shut-down
         enableSleep();                          // We are shutting the modem down anyway
         delay(100);                             // Wait for serial to be turned off
         disableModemPower();
+        if (linkBaudRate_ != ISBD_SERIAL_BAUDRATE) {
+                setLinkBaudRate(ISBD_SERIAL_BAUDRATE);  // Modem forgets AT+IPR on power down
+        }
 }     
 
 
-int ISBD::enableModem()
+int ISBD::enableModem(const unsigned long timeout_ms, ISBDCancelToken *cancel_token)
+{
+        beginOperation(timeout_ms, cancel_token);
+        return endOperation(enableModemImpl());
+}
+
+
+int ISBD::enableModemImpl()
 {
         if(modemIsEnabled_) return ISBD_SUCCESS;
         #ifdef ISBD_CONSOLE
@@ -582,8 +852,8 @@ int ISBD::enableModem()
                 #endif 
                 // In a low power application, we need to wait 
                 const unsigned long millis_start = millis();
-                while (millis() < (millis_start + lowPowerUpTimeSec_)) {
-                        if(consoleStream_->read() == 'c') {    
+                while (millis() - millis_start < lowPowerUpTimeSec_*1000UL) {
+                        if(consoleStream_->read() == 'c' || isOperationAborted()) {    
                                 #ifdef ISBD_CONSOLE
                                         console(F("Canceled\n"));
                                 #endif  
@@ -593,7 +863,7 @@ int ISBD::enableModem()
                                 modemIsEnabled_ = false;     
                                 return ISBD_ERR_NOT_SPECIFIED;
                         }
-                        delay(500);
+                        waitMs(500);
                 }
                 if ( !modemPowerUp() ) {                 
                         enableSleep();
@@ -614,7 +884,7 @@ int ISBD::disableModem()
         #ifdef ISBD_CONSOLE
                 console(F("Disable modem\n"));
         #endif 
-        modemPowerDown();
+        modemPowerDown(20);
         modemIsEnabled_ = false;
         return ISBD_SUCCESS;
 } 
@@ -629,6 +899,79 @@ void ISBD::sendToModem(const String msg)
 }
 
 
+void ISBD::beginOperation(const unsigned long timeout_ms, ISBDCancelToken *cancel_token)
+{
+        if (operationDepth_++ > 0) return;                              // Nested calls use the outer budget
+        hasDeadline_  = (timeout_ms > 0);
+        deadlineMs_   = millis() + timeout_ms;
+        cancelToken_  = cancel_token;
+}
+
+
+/**
+ * End operation 
+ * 
+ * Maps failures caused by cancellation or deadline to ISBD_ERR_CANCELED and
+ * ISBD_ERR_DEADLINE. An aborted modem may be in the middle of a command, so it
+ * is powered down to leave it in a known state. The power down is not part 
+ * of the budget and takes at most ISBD_ABORT_FLUSH_TIMEOUT_SEC.
+ */
+int ISBD::endOperation(int status)
+{
+        if (--operationDepth_ > 0) return status;
+        const bool is_canceled = (cancelToken_ && cancelToken_->is_canceled);
+        const bool is_deadline = (hasDeadline_ && (long)(millis() - deadlineMs_) >= 0);
+        hasDeadline_  = false;
+        cancelToken_  = NULL;
+        if (status == ISBD_SUCCESS || (!is_canceled && !is_deadline)) return status;
+        #ifdef ISBD_CONSOLE
+                console(is_canceled ? F("Canceled\n") : F("Deadline exceeded\n"));
+        #endif 
+        if (modemIsEnabled_) {
+                modemPowerDown(ISBD_ABORT_FLUSH_TIMEOUT_SEC);
+                modemIsEnabled_ = false;
+        }
+        return is_canceled ? ISBD_ERR_CANCELED : ISBD_ERR_DEADLINE;
+}
+
+
+bool ISBD::isOperationAborted()
+{
+        if (cancelToken_ && cancelToken_->is_canceled) return true;
+        return hasDeadline_ && (long)(millis() - deadlineMs_) >= 0;
+}
+
+
+/**
+ * Get remaining time 
+ * 
+ * Limits a wait of timeout_ms to the time left until the operation deadline.
+ */
+unsigned long ISBD::getRemainingMs(const unsigned long timeout_ms)
+{
+        if (!hasDeadline_) return timeout_ms;
+        const long remaining_ms = (long)(deadlineMs_ - millis());
+        if (remaining_ms <= 0) return 0;
+        return ((unsigned long)remaining_ms < timeout_ms) ? (unsigned long)remaining_ms : timeout_ms;
+}
+
+
+/**
+ * Wait 
+ * 
+ * delay() that returns early with false if the operation is aborted.
+ */
+bool ISBD::waitMs(const unsigned long ms)
+{
+        const unsigned long start_time_ms = millis();
+        while (millis() - start_time_ms < ms) {
+                if (isOperationAborted()) return false;
+                delay(10);
+        }
+        return true;
+}
+
+
 /**
  * Strip modem return string 
  * 
@@ -648,6 +991,142 @@ bool ISBD::stripModemReturnString(String& msg)
 }
 
 
+bool ISBD::sendFlowControlToModem()
+{
+        if (isFlowControl_) sendToModem(F("AT&K3\r"));                  // Enable RTS/CTS flow control
+        else                sendToModem(F("AT&K0\r"));                  // Disable RTS/CTS flow control for 3-wire mode
+        if ( !waitForModemResponse(10, F("OK\r\n")) ) return false;
+        return true;
+}
+
+
+/**
+ * Switch modem baudrate
+ * 
+ * The modem acknowledges AT+IPR with the old baudrate and uses the new one
+ * afterwards. The host port follows through setHostBaudRate_. If the modem 
+ * does not answer with the new baudrate, host and modem can not reach each 
+ * other anymore. The modem is then powered down, which resets AT+IPR, and 
+ * baudRate_ is set back to ISBD_SERIAL_BAUDRATE so the next power up does 
+ * not try again. The caller needs to power up the modem again.
+ */
+bool ISBD::switchModemBaudRate(const long baud_rate)
+{
+        if (baud_rate == linkBaudRate_) return true;
+        const int ipr_code = getIprCode(baud_rate);
+        if (ipr_code < 0 || !setHostBaudRate_) {                        // E.g. host baudrate function cleared after setBaudRate()
+                baudRate_ = ISBD_SERIAL_BAUDRATE;
+                return false;
+        }
+        #ifdef ISBD_CONSOLE
+                console(F("Switching baudrate to "), String(baud_rate), F("\n"));
+        #endif 
+        if (!waitMs(100)) return false;                                 // Drop pending responses of previous commands
+        flushSerialRxBuffer();
+        sendToModem("AT+IPR=" + String(ipr_code) + "\r");
+        if (waitForModemResponse(10, F("OK\r\n"))) {                   // Modem may have switched even without OK
+                iridiumStream_->flush();                                // Wait for outgoing data before switching
+                setLinkBaudRate(baud_rate);
+                waitMs(100);                                            // Wait for modem to switch
+                flushSerialRxBuffer();
+                if (getSbdAttention()) return true;
+        }
+        #ifdef ISBD_CONSOLE
+                console(F("No answer. Power cycling modem, back to "), String(ISBD_SERIAL_BAUDRATE), F("\n"));
+        #endif 
+        if (!isOperationAborted()) baudRate_ = ISBD_SERIAL_BAUDRATE;   // Do not retry a failing baudrate
+        enableSleep();
+        waitMs(100);                                                    // Wait for serial to be turned off
+        disableModemPower();
+        setLinkBaudRate(ISBD_SERIAL_BAUDRATE);
+        waitMs(ISBD_POWER_CYCLE_MS);                                    // Let modem lose power, ends early on deadline/cancel
+        return false;
+}
+
+
+void ISBD::setLinkBaudRate(const long baud_rate)
+{
+        if (setHostBaudRate_) setHostBaudRate_(baud_rate);
+        linkBaudRate_ = baud_rate;
+}
+
+
+/**
+ * Get AT+IPR code 
+ * 
+ * Returns the AT+IPR parameter for a baudrate or -1 if the baudrate is not
+ * supported by the modem.
+ * Example: 19200 -> 6
+ */
+int ISBD::getIprCode(const long baud_rate)
+{
+        const long baud_rates[] = {600, 1200, 2400, 4800, 9600, 19200, 38400, 57600, ISBD_MAX_SERIAL_BAUDRATE};
+        for (unsigned int i=0; i<sizeof(baud_rates)/sizeof(baud_rates[0]); ++i) {
+                if (baud_rates[i] == baud_rate) return i+1;
+        }
+        return -1;
+}
+
+
+unsigned long ISBD::getTimeSec()
+{
+        if (getTimeSec_) return getTimeSec_();
+        return millis()/1000;                                           // No clock, time slots are relative to start up
+}
+
+
+/**
+ * Get signal quality 
+ * 
+ * Returns the last known signal strength (0-5) without waiting for a new 
+ * measurement or -1 on failure.
+ * Example return: \r\n+CSQF:3\r\n\r\nOK\r\n    
+ */
+int ISBD::getSignalQuality()
+{
+        String response = "";
+        sendToModem(F("AT+CSQF\r"));
+        if (!waitForModemResponse(10, F("OK\r\n"), response)) return -1;
+        const int index = response.indexOf(':');
+        if (index == -1) return -1;
+        return response.substring(index+1).toInt();
+}
+
+
+void ISBD::addSessionToHistory(const unsigned long time_sec, const int signal, const byte mo_status, const byte mt_status, const unsigned long duration_ms)
+{
+        ISBDSession& session = history_.sessions[history_.next];
+        session.time_sec     = time_sec;
+        session.signal       = (signal < 0) ? 0xFF : (uint8_t)signal;         // 0xFF: unknown
+        session.mo_status    = mo_status;
+        session.mt_status    = mt_status;
+        session.duration_ds  = (duration_ms/100 > 0xFFFF) ? 0xFFFF : (uint16_t)(duration_ms/100);
+        history_.next        = (history_.next+1) % ISBD_HISTORY_SIZE;
+        if (history_.count < ISBD_HISTORY_SIZE) history_.count++;
+
+        const int slot = (time_sec / ISBD_HISTORY_SLOT_SEC) % ISBD_HISTORY_NUM_SLOTS;
+        if (history_.slot_attempts[slot] == 0xFF) {                     // Halve counters before overflow, older attempts weigh less
+                history_.slot_attempts[slot]  /= 2;
+                history_.slot_successes[slot] /= 2;
+        }
+        history_.slot_attempts[slot]++;
+        const bool is_success = (mo_status == 1) || (mo_status == 0 && mt_status < 2);  // MO 0: nothing to send, MT status tells
+        if (is_success) history_.slot_successes[slot]++;
+}
+
+
+/**
+ * Get slot success rate 
+ * 
+ * Success rate of a time slot in percent. Unknown slots start at 50% and 
+ * move towards the measured rate with every attempt.
+ */
+int ISBD::getSlotSuccessPct(const int slot)
+{
+        return (100*(history_.slot_successes[slot]+1)) / (history_.slot_attempts[slot]+2);
+}
+
+
 #ifdef ISBD_CONSOLE
         void ISBD::console(const String msg, const String data, const String ending)
         {
@@ -34,6 +34,7 @@
 
 #include "Arduino.h"
 #include "Stream.h"
+#include "ISBDLimits.h"
 
 #define ISBD_NAME       "ISBD"
 #define ISBD_VERSION    "v0.1"
@@ -49,22 +50,91 @@
 #define ISBD_ERR_LOAD_FROM_MODEM                7
 #define ISBD_ERR_GET_STATUS                     8 
 #define ISBD_ERR_CLEAR_MODEM_BUFFER             9 
+#define ISBD_ERR_BAUDRATE                       10
+#define ISBD_ERR_POSTPONED                      11      //Non-urgent message not sent outside of transmit window
+#define ISBD_ERR_CANCELED                       12      //Operation canceled with ISBDCancelToken
+#define ISBD_ERR_DEADLINE                       13      //Operation deadline exceeded
 
 
 /* CONSOLE PRINT */ 
-#define ISBD_CONSOLE                                    // Comment to disable console prints completly. This saves storage!     
+#ifndef ISBD_NO_CONSOLE
+        #define ISBD_CONSOLE                            // Comment (or build with -DISBD_NO_CONSOLE) to disable console prints completly. This saves storage!     
+#endif
 
 /* Default settings */
 #define ISBD_DEFAULT_LOW_POWER_UP_TIME_SEC      30      //[sec] Time to power up modem in low power mode
 #define ISBD_DEFAULT_TRANSMISSION_TIMEOUT_SEC   300     //[sec] Timeout for Iridium SBD message transmission
 #define ISBD_DEFAULT_NETWORK_CHECK_TIMEOUT_SEC  120     //[sec] Timeout for Iridium SBD network check
+#define ISBD_DEFAULT_FLOW_CONTROL               false   //RTS/CTS flow control (false = 3-wire mode)
+#define ISBD_POWER_CYCLE_MS                     2000    //[ms] Power off time to reset the modem after a failed baudrate switch
+#define ISBD_ABORT_FLUSH_TIMEOUT_SEC            2       //[sec] Timeout for EEPROM flush when powering down after cancel/deadline
 
 /* Irdium SBD modem settings */
-#define ISBD_SERIAL_BAUDRATE                    19200
-#define ISBD_TXT_MAX_TX_MSG_SIZE                120     //[byte] Maximum txt Tx message size (see Iridium documentation)
-#define ISBD_TXT_MAX_RX_MSG_SIZE                135     //[byte] Maximum txt Rx message size (see Iridium documentation)
-#define ISBD_BIN_MAX_TX_MSG_SIZE                340     //[byte] Maximum bin Tx message size (see Iridium documentation)
-#define ISBD_BIN_MAX_RX_MSG_SIZE                270     //[byte] Maximum bin Rx message size (see Iridium documentation)
+#define ISBD_SERIAL_BAUDRATE                    19200   //[baud] Modem baudrate after power up
+#define ISBD_MAX_SERIAL_BAUDRATE                115200  //[baud] Maximum baudrate selectable with AT+IPR
+
+/* Capacities, override with build flags, e.g. -DISBD_MT_BUFFER_SIZE=64 (see tools/footprint.sh).
+ * They change the layout of class ISBD, so they must be global build flags that ISBD.cc is compiled
+ * with too. A #define in the sketch before #include <ISBD.h> only changes the sketch's view of the
+ * class and corrupts memory. */
+#ifndef ISBD_RESPONSE_BUFFER_SIZE
+        #define ISBD_RESPONSE_BUFFER_SIZE       128     //[byte] Modem response kept while waiting for a result code (heap)
+#endif
+#ifndef ISBD_MT_BUFFER_SIZE
+        #define ISBD_MT_BUFFER_SIZE             ISBD_BIN_MAX_RX_MSG_SIZE        //[byte] Receive buffer, larger incoming messages are dropped
+#endif
+#ifndef ISBD_MAX_MSG_HANDLERS
+        #define ISBD_MAX_MSG_HANDLERS           8       //[-] Maximum number of registered incoming message handlers
+#endif
+#ifndef ISBD_HISTORY_SIZE
+        #define ISBD_HISTORY_SIZE               32      //[-] Number of session attempts kept (8 byte each)
+#endif
+#ifndef ISBD_HISTORY_NUM_SLOTS
+        #define ISBD_HISTORY_NUM_SLOTS          24      //[-] Number of time of day slots for success statistics (2 byte each)
+#endif
+
+static_assert(ISBD_RESPONSE_BUFFER_SIZE >= 64,                                  "ISBD_RESPONSE_BUFFER_SIZE must hold an +SBDI response (64 byte)");
+static_assert(ISBD_MT_BUFFER_SIZE > 0,                                          "ISBD_MT_BUFFER_SIZE must not be 0");
+static_assert(ISBD_MT_BUFFER_SIZE <= ISBD_BIN_MAX_RX_MSG_SIZE,                  "ISBD_MT_BUFFER_SIZE exceeds ISBD_BIN_MAX_RX_MSG_SIZE");
+static_assert(ISBD_MAX_MSG_HANDLERS > 0 && ISBD_MAX_MSG_HANDLERS <= 256,        "ISBD_MAX_MSG_HANDLERS must be 1 to 256 (one per opcode)");
+static_assert(ISBD_HISTORY_SIZE > 0 && ISBD_HISTORY_SIZE <= 255,                "ISBD_HISTORY_SIZE must be 1 to 255 (uint8_t index)");
+static_assert(ISBD_HISTORY_NUM_SLOTS > 0 && 86400L % ISBD_HISTORY_NUM_SLOTS == 0, "ISBD_HISTORY_NUM_SLOTS must divide the day evenly (e.g. 8, 24, 48)");
+
+/* Session history */
+#define ISBD_HISTORY_SLOT_SEC                   (86400L/ISBD_HISTORY_NUM_SLOTS) //[sec] Length of one time slot, the slots cover one day
+#define ISBD_HISTORY_WINDOW_MARGIN_PCT          10      //[%] Success rate below best slot still accepted as transmit window
+
+
+/* Cancellation token, set is_canceled e.g. from an interrupt to cancel a running operation */
+struct ISBDCancelToken {
+        volatile bool is_canceled = false;
+};
+
+/* Handler for incoming binary messages, payload points into the receive buffer and is valid until the handler returns */
+typedef void (*ISBDMsgHandler)(const uint8_t *payload, size_t payload_size);
+
+struct ISBDMsgHandlerEntry {
+        uint8_t        opcode;                                                          //First byte of the message
+        ISBDMsgHandler handler;
+};
+
+/* Session attempt (one AT+SBDI) */
+struct ISBDSession {
+        uint32_t time_sec;                                                              //Time of attempt [sec], see setTimeFunction()
+        uint8_t  signal;                                                                //Signal strength 0-5 (AT+CSQF) 
+        uint8_t  mo_status : 4;                                                         //MO status of AT+SBDI (0: no msg, 1: sent, 2: error)
+        uint8_t  mt_status : 4;                                                         //MT status of AT+SBDI (0: no msg, 1: received, 2: error)
+        uint16_t duration_ds;                                                           //Duration of attempt [1/10 sec]
+};
+
+/* Session history with fixed size of sizeof(ISBDSessionHistory) byte */
+struct ISBDSessionHistory {
+        ISBDSession sessions[ISBD_HISTORY_SIZE];                                        //Ring buffer of latest attempts
+        uint8_t     next;                                                               //Index of next entry in sessions
+        uint8_t     count;                                                              //Number of valid entries in sessions
+        uint8_t     slot_attempts[ISBD_HISTORY_NUM_SLOTS];                              //Attempts per time slot
+        uint8_t     slot_successes[ISBD_HISTORY_NUM_SLOTS];                             //Successful attempts per time slot
+};
 
 
 class ISBD 
@@ -73,14 +143,15 @@ public:
         ISBD(Stream &iridium_stream, Stream &console_stream, int modem_power_pin, int modem_sleep_pin);
         ~ISBD();
         
-        bool   getNetworkStatus();
-        int    sendTextMsg(String& msg_out);
-        int    sendReceiveTxtMsg(String& msg_out, String& msg_in, int& num_msg_in);
-        int    sendBinaryMsg(const uint8_t *tx_data, size_t tx_buffer_size);
+        bool   getNetworkStatus(unsigned long timeout_ms = 0, ISBDCancelToken *cancel_token = NULL);
+        int    sendTextMsg(String& msg_out, bool is_urgent = true, unsigned long timeout_ms = 0, ISBDCancelToken *cancel_token = NULL);
+        int    sendReceiveTxtMsg(String& msg_out, String& msg_in, int& num_msg_in, unsigned long timeout_ms = 0, ISBDCancelToken *cancel_token = NULL);
+        int    sendBinaryMsg(const uint8_t *tx_data, size_t tx_buffer_size, bool is_urgent = true, unsigned long timeout_ms = 0, ISBDCancelToken *cancel_token = NULL);
+        int    receiveMsgs(unsigned long timeout_ms = 0, ISBDCancelToken *cancel_token = NULL);
         int    sendBinaryReceiveMsg(const uint8_t *txData, size_t txDataSize, const uint8_t *rxBuffer, size_t &rxBufferSize);
 
         String getLibraryNameAndVersion();
-        int    enableModem();
+        int    enableModem(unsigned long timeout_ms = 0, ISBDCancelToken *cancel_token = NULL);
         int    disableModem();
         void   enableModemPower();
         void   disableModemPower();
@@ -98,6 +169,19 @@ public:
         int    getModemSleepPin();
         bool   getIsConsolePrint();
         bool   setIsConsolePrint(bool is_console_print);
+        bool   getIsFlowControl();
+        bool   setIsFlowControl(bool is_flow_control);
+        long   getBaudRate();
+        int    setBaudRate(long baud_rate);
+        void   setHostBaudRateFunction(void (*set_host_baud_rate)(long baud_rate));
+        bool   setMsgHandler(uint8_t opcode, ISBDMsgHandler handler);
+        unsigned int getNumUnknownMsgs();
+        unsigned int getNumMalformedMsgs();
+        void   setTimeFunction(unsigned long (*get_time_sec)());
+        long   getNextTransmitWindowSec();
+        size_t exportSessionHistory(uint8_t *buffer, size_t buffer_size);
+        bool   importSessionHistory(const uint8_t *buffer, size_t buffer_size);
+        void   printSessionHistory(Stream &stream);
 
 
 private: 
@@ -111,6 +195,21 @@ private:
         int    networkCheckTimeoutSec_  = ISBD_DEFAULT_NETWORK_CHECK_TIMEOUT_SEC;  
         bool   modemIsEnabled_          = false;
         bool   isConsolePrint_          = false;
+        bool   isFlowControl_           = ISBD_DEFAULT_FLOW_CONTROL;
+        long   baudRate_                = ISBD_SERIAL_BAUDRATE;                         //Requested baudrate 
+        long   linkBaudRate_            = ISBD_SERIAL_BAUDRATE;                         //Baudrate currently used on the serial line
+        void   (*setHostBaudRate_)(long baud_rate) = NULL;                              //Switches the host serial port baudrate
+        unsigned long (*getTimeSec_)() = NULL;                                          //Time source for session history
+        ISBDSessionHistory history_   = {};                                             //Session attempts and success statistics
+        uint8_t mtBuffer_[ISBD_MT_BUFFER_SIZE];                                         //Receive buffer for incoming messages
+        ISBDMsgHandlerEntry msgHandlers_[ISBD_MAX_MSG_HANDLERS];                        //Registered incoming message handlers
+        int    numMsgHandlers_          = 0;
+        unsigned int numUnknownMsgs_    = 0;                                            //Incoming messages without handler
+        unsigned int numMalformedMsgs_  = 0;                                            //Incoming messages failing checksum, size or empty
+        int    operationDepth_          = 0;                                            //Nesting of public operations
+        bool   hasDeadline_             = false;                                        //Operation has a deadline
+        unsigned long deadlineMs_       = 0;                                            //Operation deadline [millis()]
+        ISBDCancelToken *cancelToken_   = NULL;                                         //Operation cancellation token
         byte   gMOBuffer_               = 0;                                            //Mobile originated buffer
         byte   gMTBuffer_               = 0;                                            //Mobile terminated buffer
         int    gMTLength_               = 0;                                            //Length of incoming message [byte]
@@ -119,7 +218,7 @@ private:
         void enableSleep();
         void disableSleep();
         bool modemPowerUp();
-        void modemPowerDown();
+        void modemPowerDown(long flush_timeout_sec);
         void sendToModem(String msg);
         char readFromModem();
         int  getAvailableAtModem();
@@ -132,6 +231,8 @@ private:
         bool getSbdAttention();
         bool connectToSatellites(long timeout_sec);
         bool getIncomingTxtMsgFromModem(String& msg);
+        bool getIncomingMsgFromModem(size_t& msg_size);
+        bool dispatchIncomingMsg();
         bool strS1EndsWithS2(const String &S1, const String &S2); 
         int  clearMOBuffer();
         int  clearMTBuffer();
@@ -139,6 +240,24 @@ private:
         void clearSbdMOBuffer();
         void clearSbdMTBuffer();
         bool stripModemReturnString(String& msg);
+        bool sendFlowControlToModem();
+        bool switchModemBaudRate(long baud_rate);
+        void setLinkBaudRate(long baud_rate);
+        int  getIprCode(long baud_rate);
+        unsigned long getTimeSec();
+        int  getSignalQuality();
+        void addSessionToHistory(unsigned long time_sec, int signal, byte mo_status, byte mt_status, unsigned long duration_ms);
+        int  getSlotSuccessPct(int slot);
+        int  sendTextMsgImpl(String& msg_out, bool is_urgent);
+        int  sendReceiveTxtMsgImpl(String& msg_out, String& msg_in, int& num_msg_in);
+        int  sendBinaryMsgImpl(const uint8_t *tx_data, size_t tx_buffer_size, bool is_urgent);
+        int  enableModemImpl();
+        int  receiveMsgsImpl();
+        void beginOperation(unsigned long timeout_ms, ISBDCancelToken *cancel_token);
+        int  endOperation(int status);
+        bool isOperationAborted();
+        unsigned long getRemainingMs(unsigned long timeout_ms);
+        bool waitMs(unsigned long ms);
 
         #ifdef ISBD_CONSOLE        
                 void console(String msg);
@@ -147,4 +266,4 @@ private:
         #endif
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+/*
+ * ISBDLimits.h
+ * 
+ * Iridium SBD message size limits, shared by the ISBD library and host side
+ * code that does not use Arduino.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * Partly based on the IridumSBD Library by Mikal Hart available at http://arduiniana.org. 
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef ISBD_LIMITS_H
+#define ISBD_LIMITS_H
+
+/* Irdium SBD message limits */
+#define ISBD_TXT_MAX_TX_MSG_SIZE                120     //[byte] Maximum txt Tx message size (see Iridium documentation)
+#define ISBD_TXT_MAX_RX_MSG_SIZE                135     //[byte] Maximum txt Rx message size (see Iridium documentation)
+#define ISBD_BIN_MAX_TX_MSG_SIZE                340     //[byte] Maximum bin Tx message size (see Iridium documentation)
+#define ISBD_BIN_MAX_RX_MSG_SIZE                270     //[byte] Maximum bin Rx message size (see Iridium documentation)
+
+#endif
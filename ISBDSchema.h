@@ -0,0 +1,221 @@
+/*
+ * ISBDSchema.h
+ * 
+ * Bit-packed message schemas for the ISBD library.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * Partly based on the IridumSBD Library by Mikal Hart available at http://arduiniana.org. 
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef ISBD_SCHEMA_H
+#define ISBD_SCHEMA_H
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ISBDLimits.h"
+
+
+/**
+ * Schema field 
+ * 
+ * A field of Bits bits holding values from Min/Div to Max/Div. Values are 
+ * stored as round(value*Div)-Min and clamped to the range. 
+ * Example: ISBDField<11, -400, 850, 10> holds -40.0 to 85.0 in steps of 0.1
+ * Limits are long long, so host and MCU accept the same schemas.
+ */
+template <uint8_t Bits, long long Min, long long Max, long long Div = 1>
+struct ISBDField
+{
+        static_assert(Bits > 0 && Bits <= 32,                                   "ISBDField: 1 to 32 bits");
+        static_assert(Max > Min,                                                "ISBDField: Max must be greater than Min");
+        static_assert(Div > 0,                                                  "ISBDField: Div must be positive");
+        static_assert((unsigned long long)(Max-Min) <= (Bits == 32 ? 0xFFFFFFFFull : (1ull << Bits)-1),
+                                                                                "ISBDField: range does not fit into bits");
+
+        static const uint8_t bits = Bits;
+
+        static uint32_t quantize(float value)
+        {
+                return quantizeReal(value);
+        }
+
+        static uint32_t quantize(double value)                          // No detour over float where double is 64 bit
+        {
+                return quantizeReal(value);
+        }
+
+        template <class T>
+        static uint32_t quantize(T value)                               // Integers keep full precision
+        {
+                const long long scaled = (long long)value*Div;
+                if (scaled <= Min) return 0;
+                if (scaled >= Max) return (uint32_t)(Max-Min);
+                return (uint32_t)(scaled-Min);
+        }
+
+        /**
+         * Value of raw as float (default) or double. Use double for exact 
+         * values of fields wider than 24 bit.
+         */
+        template <class T = float>
+        static T dequantize(uint32_t raw)
+        {
+                return (T)((long long)raw + Min) / Div;
+        }
+
+        template <class T>
+        static uint32_t quantizeReal(T value)
+        {
+                const T scaled = value*Div;
+                if (scaled <= Min) return 0;
+                if (scaled >= Max) return (uint32_t)(Max-Min);
+                return (uint32_t)((long long)(scaled + (scaled >= 0 ? (T)0.5 : (T)-0.5)) - Min);
+        }
+};
+
+
+/**
+ * Write bits 
+ * 
+ * Writes the lowest bits of value MSB first to buffer, starting at bit_pos. 
+ * The buffer needs to be zeroed.
+ */
+inline void isbdWriteBits(uint8_t *buffer, size_t bit_pos, uint8_t bits, uint32_t value)
+{
+        while (bits > 0) {
+                const uint8_t free_bits = 8 - (bit_pos & 7);
+                const uint8_t n         = (bits < free_bits) ? bits : free_bits;
+                const uint8_t chunk     = (uint8_t)((value >> (bits-n)) & ((1u << n)-1));
+                buffer[bit_pos >> 3]   |= chunk << (free_bits-n);
+                bit_pos += n;
+                bits    -= n;
+        }
+}
+
+
+/**
+ * Read bits 
+ * 
+ * Reads bits MSB first from buffer, starting at bit_pos.
+ */
+inline uint32_t isbdReadBits(const uint8_t *buffer, size_t bit_pos, uint8_t bits)
+{
+        uint32_t value = 0;
+        while (bits > 0) {
+                const uint8_t free_bits = 8 - (bit_pos & 7);
+                const uint8_t n         = (bits < free_bits) ? bits : free_bits;
+                const uint8_t chunk     = (buffer[bit_pos >> 3] >> (free_bits-n)) & ((1u << n)-1);
+                value    = (value << n) | chunk;
+                bit_pos += n;
+                bits    -= n;
+        }
+        return value;
+}
+
+
+/**
+ * Message schema 
+ * 
+ * Bit-packed message of the given fields without padding. The byte layout is
+ * big endian and independent of the MCU, so the same schema decodes the 
+ * message on the server. Values decode into floats or doubles, fields wider 
+ * than 24 bit need doubles to decode exactly.
+ * Example: 
+ *      typedef ISBDSchema< ISBDField<11, -400, 850, 10>,       // Temperature [degC]
+ *                          ISBDField<7, 0, 100> >              // Battery [%]
+ *              Telemetry;
+ *      uint8_t msg[Telemetry::size];                           // 3 byte
+ *      Telemetry::encode(msg, 21.5, 87);
+ *      isbd.sendBinaryMsg(msg, Telemetry::size);
+ */
+template <class... Fields>
+struct ISBDSchema;
+
+template <>
+struct ISBDSchema<>
+{
+        static const size_t bits       = 0;
+        static const size_t num_fields = 0;
+
+        static void encodeFields(uint8_t *, size_t) {}
+        template <class T>
+        static void decodeFields(const uint8_t *, size_t, T *) {}
+};
+
+template <class Field, class... Fields>
+struct ISBDSchema<Field, Fields...>
+{
+        typedef ISBDSchema<Fields...> Rest;
+
+        static const size_t bits       = Field::bits + Rest::bits;
+        static const size_t size       = (bits+7)/8;                   //[byte] Message size
+        static const size_t num_fields = 1 + Rest::num_fields;
+
+        static_assert(size <= ISBD_BIN_MAX_TX_MSG_SIZE, "ISBDSchema: message exceeds ISBD_BIN_MAX_TX_MSG_SIZE");
+
+        /**
+         * Encode one value per field into buffer of at least size bytes. 
+         * Returns the message size.
+         */
+        template <class... Values>
+        static size_t encode(uint8_t *buffer, Values... values)
+        {
+                static_assert(sizeof...(Values) == num_fields, "ISBDSchema: one value per field needed");
+                memset(buffer, 0, size);
+                encodeFields(buffer, 0, values...);
+                return size;
+        }
+
+        /**
+         * Decode message into one float or double per field. Returns false 
+         * if the message is too short.
+         */
+        template <class T>
+        static bool decode(const uint8_t *buffer, size_t buffer_size, T *values)
+        {
+                if (buffer_size < size) return false;
+                decodeFields(buffer, 0, values);
+                return true;
+        }
+
+        template <class Value, class... Values>
+        static void encodeFields(uint8_t *buffer, size_t bit_pos, Value value, Values... values)
+        {
+                isbdWriteBits(buffer, bit_pos, Field::bits, Field::quantize(value));
+                Rest::encodeFields(buffer, bit_pos + Field::bits, values...);
+        }
+
+        template <class T>
+        static void decodeFields(const uint8_t *buffer, size_t bit_pos, T *values)
+        {
+                values[0] = Field::template dequantize<T>(isbdReadBits(buffer, bit_pos, Field::bits));
+                Rest::decodeFields(buffer, bit_pos + Field::bits, values+1);
+        }
+};
+
+#endif
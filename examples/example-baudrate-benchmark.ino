@@ -0,0 +1,139 @@
+/**
+ * Benchmark modem transfer time per payload size and baudrate
+ *
+ * Uploads binary payloads with AT+SBDWB at every supported baudrate, copies
+ * them to the MT buffer with AT+SBDTC and downloads them again with
+ * AT+SBDRB. Prints the time of both transfers. No satellite session is
+ * started and both buffers are cleared afterwards, so no credits are used.
+ * At 600 baud the largest payload takes about 6 seconds each way.
+ */
+
+
+#include "ISBD/ISBD.h"
+
+#define IRIDIUM_POWER_PIN       12
+#define IRIDIUM_SLEEP_PIN       21
+#define IRIDIUM_USE_FLOW_CONTROL false                                  // Set true if RTS/CTS are wired
+
+ISBD isbd(Serial3, Serial, IRIDIUM_POWER_PIN, IRIDIUM_SLEEP_PIN);
+
+const long   baud_rates[]    = {600, 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+const size_t payload_sizes[] = {10, 50, 100, 200, ISBD_BIN_MAX_TX_MSG_SIZE};
+
+
+void setHostBaudRate(long baud_rate)
+{
+        Serial3.end();
+        Serial3.begin(baud_rate);
+}
+
+
+void setup()
+{
+        Serial.begin(115200);
+        Serial3.begin(ISBD_SERIAL_BAUDRATE);
+
+        delay(5000);                                                    // Wait for me to start my serial monitor!
+
+        isbd.setHostBaudRateFunction(setHostBaudRate);
+        isbd.setIsFlowControl(IRIDIUM_USE_FLOW_CONTROL);
+
+        uint8_t payload[ISBD_BIN_MAX_TX_MSG_SIZE];
+        for (size_t i=0; i<sizeof(payload); ++i) payload[i] = (uint8_t)i;
+
+        print(F("baudrate, payload [byte], upload [ms], download [ms]\n"));
+        for (size_t b=0; b<sizeof(baud_rates)/sizeof(baud_rates[0]); ++b) {
+                if (isbd.setBaudRate(baud_rates[b]) != ISBD_SUCCESS) {
+                        print("Baudrate " + String(baud_rates[b]) + " not available\n");
+                        continue;
+                }
+                if (isbd.enableModem() != ISBD_SUCCESS) {
+                        print(F("Modem not available\n"));
+                        return;
+                }
+                for (size_t p=0; p<sizeof(payload_sizes)/sizeof(payload_sizes[0]); ++p) {
+                        long upload_ms   = uploadPayload(payload, payload_sizes[p]);
+                        long download_ms = (upload_ms < 0) ? -1 : downloadPayload(payload_sizes[p]);
+                        print(String(baud_rates[b]) + ", " + String(payload_sizes[p]) + ", " + String(upload_ms) + ", " + String(download_ms) + "\n");
+                        clearBuffers();
+                }
+        }
+        isbd.disableModem();
+}
+
+
+void loop()
+{
+}
+
+
+/**
+ * Upload payload to the modem MO buffer and return the time it took [ms] or
+ * -1 on failure.
+ */
+long uploadPayload(const uint8_t *payload, size_t payload_size)
+{
+        while (Serial3.available()) Serial3.read();
+        const unsigned long start_time_ms = millis();
+        Serial3.print("AT+SBDWB=" + String(payload_size) + "\r");
+        if (!waitFor("READY\r\n", 10000)) return -1;
+        uint16_t checksum = 0;
+        for (size_t i=0; i<payload_size; ++i) checksum += payload[i];
+        Serial3.write(payload, payload_size);
+        Serial3.write(checksum >> 8);
+        Serial3.write(checksum & 0xFF);
+        if (!waitFor("0\r\n\r\nOK\r\n", 10000)) return -1;
+        return millis() - start_time_ms;
+}
+
+
+/**
+ * Copy the MO buffer to the MT buffer and download it. Returns the time the
+ * download took [ms] or -1 on failure.
+ */
+long downloadPayload(size_t payload_size)
+{
+        Serial3.print("AT+SBDTC\r");
+        if (!waitFor("OK\r\n", 10000)) return -1;
+        while (Serial3.available()) Serial3.read();
+        const unsigned long start_time_ms = millis();
+        Serial3.print("AT+SBDRB\r");
+        size_t bytes_read = 0;                                          // Size, payload and checksum
+        while (bytes_read < payload_size + 4) {
+                if (Serial3.available()) {
+                        Serial3.read();
+                        bytes_read++;
+                }
+                if (millis() - start_time_ms > 20000) return -1;
+        }
+        if (!waitFor("OK\r\n", 10000)) return -1;
+        return millis() - start_time_ms;
+}
+
+
+/**
+ * Clear MO and MT buffer again
+ */
+void clearBuffers()
+{
+        Serial3.print("AT+SBDD2\r");
+        waitFor("OK\r\n", 10000);
+}
+
+
+bool waitFor(const String ending, unsigned long timeout_ms)
+{
+        String response = "";
+        const unsigned long start_time_ms = millis();
+        while (!response.endsWith(ending)) {
+                if (Serial3.available()) response += (char)Serial3.read();
+                if (millis() - start_time_ms > timeout_ms) return false;
+        }
+        return true;
+}
+
+
+void print(String msg)
+{
+        Serial.print(msg);
+}
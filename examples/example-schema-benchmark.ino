@@ -0,0 +1,106 @@
+/**
+ * Bit-packed telemetry with ISBDSchema
+ *
+ * Encodes a telemetry message with a schema and by hand and prints the
+ * encode time of both, including a byte checksum of each message. The schema message is then sent as binary message.
+ */
+
+
+#include "ISBD/ISBD.h"
+#include "ISBD/ISBDSchema.h"
+
+#define IRIDIUM_POWER_PIN       12
+#define IRIDIUM_SLEEP_PIN       21
+#define NUM_ENCODES             10000
+
+ISBD isbd(Serial3, Serial, IRIDIUM_POWER_PIN, IRIDIUM_SLEEP_PIN);
+
+typedef ISBDSchema< ISBDField<32, 0, 2147483647L>,                      // Time [sec]
+                    ISBDField<25, -9000000, 9000000, 100000>,           // Latitude [deg]
+                    ISBDField<26, -18000000, 18000000, 100000>,         // Longitude [deg]
+                    ISBDField<11, -400, 850, 10>,                       // Temperature [degC]
+                    ISBDField<10, 0, 1000, 100>,                        // Battery [V]
+                    ISBDField<7, 0, 100> >                              // Humidity [%]
+        Telemetry;                                                      // 14 byte instead of 17 byte by hand
+
+
+/**
+ * Hand packed reference: byte aligned, little endian on most MCUs
+ */
+struct __attribute__((packed)) TelemetryStruct {
+        uint32_t time_sec;
+        int32_t  latitude;
+        int32_t  longitude;
+        int16_t  temperature;
+        uint16_t battery;
+        uint8_t  humidity;
+};
+
+
+void setup()
+{
+        Serial.begin(115200);
+        Serial3.begin(ISBD_SERIAL_BAUDRATE);
+
+        delay(5000);                                                    // Wait for me to start my serial monitor!
+
+        volatile float latitude    = 59.35;                             // Volatile: keep the compiler from folding the loop
+        volatile float longitude   = 18.07;
+        volatile float temperature = 21.5;
+        volatile float battery     = 3.71;
+        volatile int   humidity    = 45;
+
+        uint8_t  schema_msg[Telemetry::size];
+        uint32_t schema_checksum = 0;                                   // Printed: keeps the compiler from dropping the encodes
+        unsigned long start_time_us = micros();
+        for (long i=0; i<NUM_ENCODES; ++i) {
+                Telemetry::encode(schema_msg, i, latitude, longitude, temperature, battery, humidity);
+                schema_checksum += checksum(schema_msg, sizeof(schema_msg));
+        }
+        const unsigned long schema_us = micros() - start_time_us;
+
+        uint8_t  hand_msg[sizeof(TelemetryStruct)];
+        uint32_t hand_checksum = 0;
+        start_time_us = micros();
+        for (long i=0; i<NUM_ENCODES; ++i) {
+                TelemetryStruct telemetry;
+                telemetry.time_sec    = i;
+                telemetry.latitude    = (int32_t)(latitude*100000);
+                telemetry.longitude   = (int32_t)(longitude*100000);
+                telemetry.temperature = (int16_t)(temperature*10);
+                telemetry.battery     = (uint16_t)(battery*100);
+                telemetry.humidity    = humidity;
+                memcpy(hand_msg, &telemetry, sizeof(telemetry));
+                hand_checksum += checksum(hand_msg, sizeof(hand_msg));
+        }
+        const unsigned long hand_us = micros() - start_time_us;
+
+        print("Schema: " + String(Telemetry::size) + " byte, " + String((float)schema_us/NUM_ENCODES, 3) + " us/encode (checksum " + String(schema_checksum) + ")\n");
+        print("Hand:   " + String(sizeof(hand_msg)) + " byte, " + String((float)hand_us/NUM_ENCODES, 3) + " us/encode (checksum " + String(hand_checksum) + ")\n");
+
+        Telemetry::encode(schema_msg, millis()/1000, latitude, longitude, temperature, battery, humidity);
+        int status = isbd.sendBinaryMsg(schema_msg, Telemetry::size);
+        print("Send return code = " + String(status) + "\n");
+}
+
+
+void loop()
+{
+}
+
+
+/**
+ * Sum of all bytes. Both encode loops add it, so both pay the same.
+ */
+uint32_t checksum(const uint8_t *msg, size_t msg_size)
+{
+        uint32_t sum = 0;
+        for (size_t i=0; i<msg_size; ++i) sum += msg[i];
+        return sum;
+}
+
+
+void print(String msg)
+{
+        Serial.print(msg);
+}
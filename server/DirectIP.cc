@@ -0,0 +1,187 @@
+/*
+ * DirectIP.cc
+ * 
+ * Iridium SBD DirectIP MO message format (ground side of the ISBD library).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "DirectIP.h"
+#include <string.h>
+
+
+static uint16_t readUint16(const uint8_t *data)
+{
+        return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+static uint32_t readUint32(const uint8_t *data)
+{
+        return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static void writeUint16(uint8_t *data, uint16_t value)
+{
+        data[0] = value >> 8;
+        data[1] = value & 0xFF;
+}
+
+static void writeUint32(uint8_t *data, uint32_t value)
+{
+        data[0] = value >> 24;
+        data[1] = (value >> 16) & 0xFF;
+        data[2] = (value >> 8) & 0xFF;
+        data[3] = value & 0xFF;
+}
+
+
+/**
+ * Parse MO message 
+ * 
+ * Parses a complete DirectIP MO message (pre-header and all IEs) without
+ * copying. Unknown IEs are skipped. Returns false if the message is 
+ * truncated or an IE has the wrong size.
+ */
+bool parseDirectIPMoMsg(const uint8_t *data, const size_t size, DirectIPMoMsg& msg)
+{
+        memset(&msg, 0, sizeof(msg));
+        if (size < DIRECTIP_PRE_HEADER_SIZE)                            return false;
+        if (data[0] != DIRECTIP_PROTOCOL_REVISION)                      return false;
+        const size_t msg_size = DIRECTIP_PRE_HEADER_SIZE + readUint16(data+1);
+        if (msg_size > size)                                            return false;
+
+        size_t pos = DIRECTIP_PRE_HEADER_SIZE;
+        while (pos < msg_size) {
+                if (pos + DIRECTIP_IE_HEADER_SIZE > msg_size)           return false;
+                const uint8_t  iei     = data[pos];
+                const size_t   ie_size = readUint16(data+pos+1);
+                const uint8_t *ie      = data + pos + DIRECTIP_IE_HEADER_SIZE;
+                pos += DIRECTIP_IE_HEADER_SIZE + ie_size;
+                if (pos > msg_size)                                     return false;
+
+                if (iei == DIRECTIP_IEI_MO_HEADER) {
+                        if (ie_size != DIRECTIP_MO_HEADER_SIZE)         return false;
+                        msg.has_header     = true;
+                        msg.cdr_reference  = readUint32(ie);
+                        msg.imei           = (const char *)(ie+4);
+                        msg.session_status = ie[19];
+                        msg.momsn          = readUint16(ie+20);
+                        msg.mtmsn          = readUint16(ie+22);
+                        msg.session_time   = readUint32(ie+24);
+                } else if (iei == DIRECTIP_IEI_MO_PAYLOAD) {
+                        msg.payload        = ie;
+                        msg.payload_size   = ie_size;
+                } else if (iei == DIRECTIP_IEI_MO_LOCATION) {
+                        if (ie_size != DIRECTIP_MO_LOCATION_SIZE)       return false;
+                        const bool is_south = ie[0] & 0x02;
+                        const bool is_west  = ie[0] & 0x01;
+                        msg.has_location   = true;
+                        msg.latitude       = (ie[1] + readUint16(ie+2)/60000.0) * (is_south ? -1 : 1);   // Degrees and thousandths of minutes
+                        msg.longitude      = (ie[4] + readUint16(ie+5)/60000.0) * (is_west  ? -1 : 1);
+                        msg.cep_radius_km  = readUint32(ie+7);
+                }
+        }
+        return msg.has_header;
+}
+
+
+/**
+ * Build MO message 
+ * 
+ * Builds a DirectIP MO message as sent by the Iridium gateway, e.g. for load 
+ * tests. Returns the message size or 0 if buffer is too small.
+ */
+size_t buildDirectIPMoMsg(uint8_t *buffer, const size_t buffer_size, const DirectIPMoMsg& msg)
+{
+        size_t msg_size = DIRECTIP_PRE_HEADER_SIZE + DIRECTIP_IE_HEADER_SIZE + DIRECTIP_MO_HEADER_SIZE;
+        if (msg.payload)      msg_size += DIRECTIP_IE_HEADER_SIZE + msg.payload_size;
+        if (msg.has_location) msg_size += DIRECTIP_IE_HEADER_SIZE + DIRECTIP_MO_LOCATION_SIZE;
+        if (msg_size > buffer_size || msg_size > DIRECTIP_MAX_MSG_SIZE) return 0;
+
+        uint8_t *pos = buffer;
+        pos[0] = DIRECTIP_PROTOCOL_REVISION;
+        writeUint16(pos+1, (uint16_t)(msg_size - DIRECTIP_PRE_HEADER_SIZE));
+        pos += DIRECTIP_PRE_HEADER_SIZE;
+
+        pos[0] = DIRECTIP_IEI_MO_HEADER;
+        writeUint16(pos+1, DIRECTIP_MO_HEADER_SIZE);
+        pos += DIRECTIP_IE_HEADER_SIZE;
+        writeUint32(pos, msg.cdr_reference);
+        memset(pos+4, '0', DIRECTIP_IMEI_SIZE);
+        if (msg.imei) memcpy(pos+4, msg.imei, DIRECTIP_IMEI_SIZE);
+        pos[19] = msg.session_status;
+        writeUint16(pos+20, msg.momsn);
+        writeUint16(pos+22, msg.mtmsn);
+        writeUint32(pos+24, msg.session_time);
+        pos += DIRECTIP_MO_HEADER_SIZE;
+
+        if (msg.payload) {
+                pos[0] = DIRECTIP_IEI_MO_PAYLOAD;
+                writeUint16(pos+1, (uint16_t)msg.payload_size);
+                memcpy(pos + DIRECTIP_IE_HEADER_SIZE, msg.payload, msg.payload_size);
+                pos += DIRECTIP_IE_HEADER_SIZE + msg.payload_size;
+        }
+
+        if (msg.has_location) {
+                const double latitude  = (msg.latitude  < 0) ? -msg.latitude  : msg.latitude;
+                const double longitude = (msg.longitude < 0) ? -msg.longitude : msg.longitude;
+                pos[0] = DIRECTIP_IEI_MO_LOCATION;
+                writeUint16(pos+1, DIRECTIP_MO_LOCATION_SIZE);
+                pos += DIRECTIP_IE_HEADER_SIZE;
+                pos[0] = (msg.latitude < 0 ? 0x02 : 0) | (msg.longitude < 0 ? 0x01 : 0);
+                pos[1] = (uint8_t)latitude;
+                writeUint16(pos+2, (uint16_t)((latitude - pos[1]) * 60000 + 0.5));
+                pos[4] = (uint8_t)longitude;
+                writeUint16(pos+5, (uint16_t)((longitude - pos[4]) * 60000 + 0.5));
+                writeUint32(pos+7, msg.cep_radius_km);
+        }
+        return msg_size;
+}
+
+
+/**
+ * Build MO confirmation 
+ * 
+ * Confirmation sent back to the Iridium gateway on the same connection. 
+ * Buffer needs DIRECTIP_MO_CONFIRMATION_MSG_SIZE bytes.
+ */
+size_t buildDirectIPConfirmation(uint8_t *buffer, const bool success)
+{
+        buffer[0] = DIRECTIP_PROTOCOL_REVISION;
+        writeUint16(buffer+1, DIRECTIP_MO_CONFIRMATION_MSG_SIZE - DIRECTIP_PRE_HEADER_SIZE);
+        buffer[3] = DIRECTIP_IEI_MO_CONFIRMATION;
+        writeUint16(buffer+4, 1);
+        buffer[6] = success ? 1 : 0;
+        return DIRECTIP_MO_CONFIRMATION_MSG_SIZE;
+}
+
+
+bool parseDirectIPConfirmation(const uint8_t *data, const size_t size, bool& success)
+{
+        if (size < DIRECTIP_MO_CONFIRMATION_MSG_SIZE)                   return false;
+        if (data[0] != DIRECTIP_PROTOCOL_REVISION)                      return false;
+        if (data[3] != DIRECTIP_IEI_MO_CONFIRMATION)                    return false;
+        success = (data[6] == 1);
+        return true;
+}
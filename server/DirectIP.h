@@ -0,0 +1,85 @@
+/*
+ * DirectIP.h
+ * 
+ * Iridium SBD DirectIP MO message format (ground side of the ISBD library).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef DIRECTIP_H
+#define DIRECTIP_H
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* DirectIP protocol */
+#define DIRECTIP_PROTOCOL_REVISION              1
+#define DIRECTIP_PRE_HEADER_SIZE                3       //[byte] Protocol revision[1], overall message length[2]
+#define DIRECTIP_IE_HEADER_SIZE                 3       //[byte] IEI[1], IE length[2]
+#define DIRECTIP_MAX_MSG_SIZE                   (DIRECTIP_PRE_HEADER_SIZE + 65535)
+#define DIRECTIP_IMEI_SIZE                      15      //[byte] IMEI as ASCII digits
+
+/* Information element identifiers */
+#define DIRECTIP_IEI_MO_HEADER                  0x01
+#define DIRECTIP_IEI_MO_PAYLOAD                 0x02
+#define DIRECTIP_IEI_MO_LOCATION                0x03
+#define DIRECTIP_IEI_MO_CONFIRMATION            0x05
+
+#define DIRECTIP_MO_HEADER_SIZE                 28      //[byte] CDR[4], IMEI[15], status[1], MOMSN[2], MTMSN[2], time[4]
+#define DIRECTIP_MO_LOCATION_SIZE               11      //[byte] Orientation[1], lat[3], lon[3], CEP radius[4]
+#define DIRECTIP_MO_CONFIRMATION_MSG_SIZE       7       //[byte] Pre-header[3], IE header[3], status[1]
+
+
+/**
+ * MO message 
+ * 
+ * Parsed in place: imei and payload point into the receive buffer and are 
+ * valid as long as the buffer is.
+ */
+struct DirectIPMoMsg {
+        bool            has_header;
+        uint32_t        cdr_reference;                  //Call detail record reference
+        const char     *imei;                           //DIRECTIP_IMEI_SIZE chars, not terminated
+        uint8_t         session_status;                 //0-2: success, see Iridium documentation
+        uint16_t        momsn;
+        uint16_t        mtmsn;
+        uint32_t        session_time;                   //[sec] Unix time of the session
+
+        const uint8_t  *payload;                        //NULL if message has no payload
+        size_t          payload_size;
+
+        bool            has_location;
+        double          latitude;                       //[deg] North positive
+        double          longitude;                      //[deg] East positive
+        uint32_t        cep_radius_km;                  //[km] Location accuracy
+};
+
+
+bool   parseDirectIPMoMsg(const uint8_t *data, size_t size, DirectIPMoMsg& msg);
+size_t buildDirectIPMoMsg(uint8_t *buffer, size_t buffer_size, const DirectIPMoMsg& msg);
+size_t buildDirectIPConfirmation(uint8_t *buffer, bool success);
+bool   parseDirectIPConfirmation(const uint8_t *data, size_t size, bool& success);
+
+#endif
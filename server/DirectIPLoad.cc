@@ -0,0 +1,139 @@
+/*
+ * DirectIPLoad.cc
+ * 
+ * DirectIP load generator, acts as the Iridium gateway for tests and benchmarks.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "DirectIPLoad.h"
+#include "DirectIP.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+
+/**
+ * Send one MO message on a new connection like the Iridium gateway does and 
+ * wait for the confirmation.
+ */
+static bool sendMoMsg(const sockaddr_in& addr, const uint8_t *msg, const size_t msg_size)
+{
+        const int sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock < 0) return false;
+        bool success = false;
+        if (connect(sock, (const sockaddr *)&addr, sizeof(addr)) == 0
+            && send(sock, msg, msg_size, MSG_NOSIGNAL) == (ssize_t)msg_size) {
+                uint8_t confirmation[DIRECTIP_MO_CONFIRMATION_MSG_SIZE];
+                size_t  received = 0;
+                while (received < sizeof(confirmation)) {
+                        const ssize_t n = recv(sock, confirmation + received, sizeof(confirmation) - received, 0);
+                        if (n <= 0) break;
+                        received += n;
+                }
+                parseDirectIPConfirmation(confirmation, received, success);
+        }
+        close(sock);
+        return success;
+}
+
+
+/**
+ * Run load 
+ * 
+ * Sends num_msgs MO messages with the given payload over num_connections 
+ * parallel clients and measures throughput and latency per message.
+ */
+bool runDirectIPLoad(const char *address, const uint16_t port, const int num_connections, const unsigned long num_msgs, 
+                     const uint8_t *payload, const size_t payload_size, DirectIPLoadResult& result)
+{
+        result = DirectIPLoadResult();
+        if (num_connections < 1) return false;
+        sockaddr_in addr = {};
+        addr.sin_family  = AF_INET;
+        addr.sin_port    = htons(port);
+        if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) return false;
+
+        std::atomic<unsigned long>          next_msg(0);
+        std::atomic<unsigned long>          num_failures(0);
+        std::vector<std::vector<double> >   latencies_us(num_connections);
+        std::vector<std::thread>            clients;
+
+        const Clock::time_point start_time = Clock::now();
+        for (int c=0; c<num_connections; ++c) {
+                clients.push_back(std::thread([&, c]() {
+                        std::vector<uint8_t> msg(DIRECTIP_MAX_MSG_SIZE);
+                        DirectIPMoMsg mo     = DirectIPMoMsg();
+                        mo.imei              = "300234010000000";
+                        mo.payload           = payload;
+                        mo.payload_size      = payload_size;
+                        mo.has_location      = true;
+                        mo.latitude          = 59.35;
+                        mo.longitude         = 18.07;
+                        mo.cep_radius_km     = 3;
+                        latencies_us[c].reserve(num_msgs / num_connections + 1);
+                        for (unsigned long i = next_msg++; i < num_msgs; i = next_msg++) {
+                                mo.cdr_reference = (uint32_t)i;
+                                mo.momsn         = (uint16_t)i;
+                                mo.session_time  = (uint32_t)time(NULL);
+                                const size_t msg_size = buildDirectIPMoMsg(msg.data(), msg.size(), mo);
+                                const Clock::time_point sent_time = Clock::now();
+                                if (!sendMoMsg(addr, msg.data(), msg_size)) {
+                                        num_failures++;
+                                        continue;
+                                }
+                                latencies_us[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent_time).count());
+                        }
+                }));
+        }
+        for (size_t c=0; c<clients.size(); ++c) {
+                clients[c].join();
+        }
+        result.duration_sec = std::chrono::duration<double>(Clock::now() - start_time).count();
+
+        std::vector<double> latency_us;
+        for (size_t c=0; c<latencies_us.size(); ++c) {
+                latency_us.insert(latency_us.end(), latencies_us[c].begin(), latencies_us[c].end());
+        }
+        std::sort(latency_us.begin(), latency_us.end());
+        result.num_msgs     = latency_us.size();
+        result.num_failures = num_failures;
+        if (latency_us.empty()) return false;
+        result.msgs_per_sec   = result.num_msgs / result.duration_sec;
+        result.latency_p50_us = latency_us[latency_us.size() / 2];
+        result.latency_p99_us = latency_us[(latency_us.size() * 99) / 100];
+        result.latency_max_us = latency_us.back();
+        return true;
+}
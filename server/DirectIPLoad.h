@@ -0,0 +1,52 @@
+/*
+ * DirectIPLoad.h
+ * 
+ * DirectIP load generator, acts as the Iridium gateway for tests and benchmarks.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef DIRECTIP_LOAD_H
+#define DIRECTIP_LOAD_H
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+struct DirectIPLoadResult {
+        unsigned long num_msgs;                         //Confirmed messages
+        unsigned long num_failures;                     //Connection errors and failure confirmations
+        double        duration_sec;
+        double        msgs_per_sec;
+        double        latency_p50_us;                   //[us] Connect to confirmation
+        double        latency_p99_us;
+        double        latency_max_us;
+};
+
+
+bool runDirectIPLoad(const char *address, uint16_t port, int num_connections, unsigned long num_msgs, 
+                     const uint8_t *payload, size_t payload_size, DirectIPLoadResult& result);
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * DirectIPServer.cc
+ * 
+ * Multithreaded DirectIP MO receiver (ground side of the ISBD library).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "DirectIPServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+
+
+/**
+ * Receive exactly size bytes before deadline. Returns false on timeout or 
+ * closed connection. The deadline covers the whole message, so a peer that
+ * trickles single bytes can not hold a worker.
+ */
+static bool receiveAll(const int socket, uint8_t *buffer, size_t size, const std::chrono::steady_clock::time_point deadline)
+{
+        while (size > 0) {
+                const long remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (remaining_ms <= 0) return false;
+                struct pollfd pfd = {socket, POLLIN, 0};
+                if (poll(&pfd, 1, remaining_ms) <= 0) return false;
+                const ssize_t n = recv(socket, buffer, size, MSG_DONTWAIT);
+                if (n <= 0) return false;
+                buffer += n;
+                size   -= n;
+        }
+        return true;
+}
+
+
+DirectIPServer::DirectIPServer(DirectIPMoHandler handler, void *context)
+        : handler_(handler), context_(context), isConfirmation_(true), isRunning_(false), numMsgs_(0), numMalformedMsgs_(0)
+{
+}
+
+
+DirectIPServer::~DirectIPServer()
+{
+        stop();
+}
+
+
+bool DirectIPServer::start(const char *address, const uint16_t port, const int num_threads)
+{
+        if (isRunning_ || num_threads < 1) return false;
+
+        listenSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenSocket_ < 0) return false;
+        const int reuse = 1;
+        setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr = {};
+        addr.sin_family  = AF_INET;
+        addr.sin_port    = htons(port);
+        if (inet_pton(AF_INET, address, &addr.sin_addr) != 1
+            || bind(listenSocket_, (sockaddr *)&addr, sizeof(addr)) != 0
+            || listen(listenSocket_, DIRECTIP_LISTEN_BACKLOG) != 0) {
+                close(listenSocket_);
+                listenSocket_ = -1;
+                return false;
+        }
+        socklen_t addr_size = sizeof(addr);
+        getsockname(listenSocket_, (sockaddr *)&addr, &addr_size);
+        port_ = ntohs(addr.sin_port);                                   // Port 0 picks a free port
+
+        isRunning_ = true;
+        for (int i=0; i<num_threads; ++i) {
+                workers_.push_back(std::thread(&DirectIPServer::runWorker, this));
+        }
+        return true;
+}
+
+
+void DirectIPServer::stop()
+{
+        if (!isRunning_) return;
+        isRunning_ = false;
+        shutdown(listenSocket_, SHUT_RDWR);                             // Wakes up workers blocked in accept()
+        for (size_t i=0; i<workers_.size(); ++i) {
+                workers_[i].join();
+        }
+        workers_.clear();
+        close(listenSocket_);
+        listenSocket_ = -1;
+}
+
+
+uint16_t DirectIPServer::getPort()
+{
+        return port_;
+}
+
+unsigned long DirectIPServer::getNumMsgs()
+{
+        return numMsgs_;
+}
+
+unsigned long DirectIPServer::getNumMalformedMsgs()
+{
+        return numMalformedMsgs_;
+}
+
+void DirectIPServer::setIsConfirmation(const bool is_confirmation)
+{
+        isConfirmation_ = is_confirmation;
+}
+
+
+void DirectIPServer::runWorker()
+{
+        std::vector<uint8_t> buffer(DIRECTIP_MAX_MSG_SIZE);            // Allocated once per worker
+        while (isRunning_) {
+                const int socket = accept(listenSocket_, NULL, NULL);
+                if (socket < 0) {
+                        if (errno != EINTR && errno != ECONNABORTED) {  // Persistent (e.g. out of file descriptors) until connections close
+                                std::this_thread::sleep_for(std::chrono::milliseconds(DIRECTIP_ACCEPT_BACKOFF_MS));
+                        }
+                        continue;
+                }
+                handleConnection(socket, buffer.data());
+                close(socket);
+        }
+}
+
+
+void DirectIPServer::handleConnection(const int socket, uint8_t *buffer)
+{
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(DIRECTIP_RECEIVE_TIMEOUT_SEC);
+        if (!receiveAll(socket, buffer, DIRECTIP_PRE_HEADER_SIZE, deadline)) return;
+        const size_t ie_size = (buffer[1] << 8) | buffer[2];
+        if (!receiveAll(socket, buffer + DIRECTIP_PRE_HEADER_SIZE, ie_size, deadline)) return;
+
+        DirectIPMoMsg msg;
+        bool success = parseDirectIPMoMsg(buffer, DIRECTIP_PRE_HEADER_SIZE + ie_size, msg);
+        if (success) {
+                numMsgs_++;
+                if (handler_) success = handler_(msg, context_);
+        } else {
+                numMalformedMsgs_++;
+        }
+
+        if (!isConfirmation_) return;
+        uint8_t confirmation[DIRECTIP_MO_CONFIRMATION_MSG_SIZE];
+        buildDirectIPConfirmation(confirmation, success);
+        send(socket, confirmation, sizeof(confirmation), MSG_NOSIGNAL);
+}
@@ -0,0 +1,87 @@
+/*
+ * DirectIPServer.h
+ * 
+ * Multithreaded DirectIP MO receiver (ground side of the ISBD library).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef DIRECTIP_SERVER_H
+#define DIRECTIP_SERVER_H
+
+
+#include "DirectIP.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define DIRECTIP_DEFAULT_NUM_THREADS            4
+#define DIRECTIP_RECEIVE_TIMEOUT_SEC            10      //[sec] Drop connections that do not deliver the whole message in time
+#define DIRECTIP_LISTEN_BACKLOG                 256
+#define DIRECTIP_ACCEPT_BACKOFF_MS              10      //[ms] Wait after accept() errors like EMFILE instead of spinning
+
+
+/* Handler for MO messages, called on a worker thread. msg points into the worker's buffer and is valid until the handler returns. Return false to confirm failure. */
+typedef bool (*DirectIPMoHandler)(const DirectIPMoMsg& msg, void *context);
+
+
+/**
+ * DirectIP server 
+ * 
+ * The Iridium gateway opens one TCP connection per MO message. Each worker 
+ * thread accepts connections on the shared socket, reads the message into 
+ * its own preallocated buffer, parses it in place, calls the handler and 
+ * sends the confirmation. No memory is allocated per message.
+ */
+class DirectIPServer 
+{
+public:
+        DirectIPServer(DirectIPMoHandler handler, void *context);
+        ~DirectIPServer();
+
+        bool     start(const char *address, uint16_t port, int num_threads = DIRECTIP_DEFAULT_NUM_THREADS);
+        void     stop();
+        uint16_t getPort();
+        unsigned long getNumMsgs();
+        unsigned long getNumMalformedMsgs();
+        void     setIsConfirmation(bool is_confirmation);
+
+
+private:
+        DirectIPMoHandler handler_;
+        void             *context_;
+        int               listenSocket_         = -1;
+        uint16_t          port_                 = 0;
+        std::atomic<bool> isConfirmation_;
+        std::atomic<bool> isRunning_;
+        std::atomic<unsigned long> numMsgs_;
+        std::atomic<unsigned long> numMalformedMsgs_;
+        std::vector<std::thread>   workers_;
+
+        void runWorker();
+        void handleConnection(int socket, uint8_t *buffer);
+};
+
+#endif
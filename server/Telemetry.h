@@ -0,0 +1,44 @@
+/*
+ * Telemetry.h
+ * 
+ * Telemetry schema of examples/example-schema-benchmark.ino for the DirectIP tools.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+
+#include "../ISBDSchema.h"
+
+typedef ISBDSchema< ISBDField<32, 0, 2147483647L>,                      // Time [sec]
+                    ISBDField<25, -9000000, 9000000, 100000>,           // Latitude [deg]
+                    ISBDField<26, -18000000, 18000000, 100000>,         // Longitude [deg]
+                    ISBDField<11, -400, 850, 10>,                       // Temperature [degC]
+                    ISBDField<10, 0, 1000, 100>,                        // Battery [V]
+                    ISBDField<7, 0, 100> >                              // Humidity [%]
+        Telemetry;
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * directip_bench.cc
+ * 
+ * DirectIP throughput and latency benchmark.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+/*
+ * Runs the DirectIP server on loopback and loads it with telemetry messages 
+ * for several worker thread counts. With address and port given, only the 
+ * load is generated against that server.
+ * 
+ * Usage:   directip_bench [messages] [connections] [address port]
+ * Example: directip_bench 20000 32
+ */
+
+#include "DirectIPLoad.h"
+#include "DirectIPServer.h"
+#include "Telemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+
+
+static bool onMoMsg(const DirectIPMoMsg& msg, void *context)
+{
+        float values[Telemetry::num_fields];
+        if (!Telemetry::decode(msg.payload, msg.payload_size, values)) return false;
+        *(std::atomic<unsigned long> *)context += 1;
+        return true;
+}
+
+
+static void printResult(const char *label, const DirectIPLoadResult& result)
+{
+        printf("%-10s %10lu %8lu %12.0f %12.1f %12.1f %12.1f\n", label, result.num_msgs, result.num_failures,
+               result.msgs_per_sec, result.latency_p50_us, result.latency_p99_us, result.latency_max_us);
+}
+
+
+int main(int argc, char **argv)
+{
+        const unsigned long num_msgs        = (argc > 1) ? strtoul(argv[1], NULL, 10) : 20000;
+        const int           num_connections = (argc > 2) ? atoi(argv[2]) : 32;
+
+        uint8_t payload[Telemetry::size];
+        Telemetry::encode(payload, 1500000000L, 59.35f, 18.07f, 21.5f, 3.71f, 45);
+
+        printf("%-10s %10s %8s %12s %12s %12s %12s\n", "threads", "msgs", "failed", "msgs/s", "p50 [us]", "p99 [us]", "max [us]");
+        DirectIPLoadResult result;
+        if (argc > 4) {
+                runDirectIPLoad(argv[3], atoi(argv[4]), num_connections, num_msgs, payload, sizeof(payload), result);
+                printResult("remote", result);
+                return result.num_failures ? 1 : 0;
+        }
+
+        const int thread_counts[] = {1, 2, 4, 8};
+        for (size_t i=0; i<sizeof(thread_counts)/sizeof(thread_counts[0]); ++i) {
+                std::atomic<unsigned long> num_decoded(0);
+                DirectIPServer server(onMoMsg, &num_decoded);
+                if (!server.start("127.0.0.1", 0, thread_counts[i])) {
+                        fprintf(stderr, "Can not start server\n");
+                        return 1;
+                }
+                runDirectIPLoad("127.0.0.1", server.getPort(), num_connections, num_msgs, payload, sizeof(payload), result);
+                server.stop();
+                char label[16];
+                snprintf(label, sizeof(label), "%d", thread_counts[i]);
+                printResult(label, result);
+                if (result.num_failures || num_decoded != num_msgs) {
+                        fprintf(stderr, "%lu of %lu messages decoded\n", (unsigned long)num_decoded, num_msgs);
+                        return 1;
+                }
+        }
+        return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * directip_server.cc
+ * 
+ * DirectIP MO receiver printing decoded telemetry as CSV.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+/*
+ * Usage:   directip_server [address] [port] [threads]
+ * Example: directip_server 0.0.0.0 10800 4
+ */
+
+#include "DirectIPServer.h"
+#include "Telemetry.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <mutex>
+
+static std::mutex output_mutex;
+static volatile sig_atomic_t is_stopped = 0;
+
+
+static void onSignal(int)
+{
+        is_stopped = 1;
+}
+
+
+static bool onMoMsg(const DirectIPMoMsg& msg, void *)
+{
+        double values[Telemetry::num_fields];                           // Exact 32 bit time
+        if (!Telemetry::decode(msg.payload, msg.payload_size, values)) return false;
+        std::lock_guard<std::mutex> lock(output_mutex);
+        printf("%.15s,%u,%u,%.0f,%.5f,%.5f,%.1f,%.2f,%.0f\n", msg.imei, msg.momsn, msg.session_time,
+               values[0], values[1], values[2], values[3], values[4], values[5]);
+        return true;
+}
+
+
+int main(int argc, char **argv)
+{
+        const char *address     = (argc > 1) ? argv[1] : "0.0.0.0";
+        const int   port        = (argc > 2) ? atoi(argv[2]) : 10800;
+        const int   num_threads = (argc > 3) ? atoi(argv[3]) : DIRECTIP_DEFAULT_NUM_THREADS;
+
+        DirectIPServer server(onMoMsg, NULL);
+        if (!server.start(address, port, num_threads)) {
+                fprintf(stderr, "Can not listen on %s:%d\n", address, port);
+                return 1;
+        }
+        signal(SIGINT,  onSignal);
+        signal(SIGTERM, onSignal);
+        fprintf(stderr, "Listening on %s:%u with %d threads\n", address, server.getPort(), num_threads);
+        printf("imei,momsn,session_time,time_sec,latitude,longitude,temperature,battery,humidity\n");
+        while (!is_stopped) {
+                pause();
+        }
+        server.stop();
+        fprintf(stderr, "%lu messages, %lu malformed\n", server.getNumMsgs(), server.getNumMalformedMsgs());
+        return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Arduino.cc
+ * 
+ * Minimal Arduino core for running ISBD.cc on a Linux host (test only).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "Arduino.h"
+#include "Stream.h"
+#include <stdio.h>
+#include <string.h>
+
+static unsigned long gNowMs_ = 0;
+static void (*gDigitalWriteHook_)(int, int) = NULL;
+
+
+String::String(double value, int decimals)
+{
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        str_ = buffer;
+}
+
+
+bool String::endsWith(const String &s) const
+{
+        return str_.size() >= s.str_.size() && str_.compare(str_.size()-s.str_.size(), s.str_.size(), s.str_) == 0;
+}
+
+
+int String::indexOf(char c, unsigned int from) const
+{
+        const size_t index = str_.find(c, from);
+        return (index == std::string::npos) ? -1 : (int)index;
+}
+
+
+int String::indexOf(const String &s, unsigned int from) const
+{
+        const size_t index = str_.find(s.str_, from);
+        return (index == std::string::npos) ? -1 : (int)index;
+}
+
+
+String String::substring(unsigned int from) const
+{
+        if (from > str_.size()) return String();
+        return String(str_.substr(from));
+}
+
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+        if (from > str_.size() || to < from) return String();
+        return String(str_.substr(from, to-from));
+}
+
+
+void String::trim()
+{
+        const size_t first = str_.find_first_not_of(" \t\r\n");
+        const size_t last  = str_.find_last_not_of(" \t\r\n");
+        str_ = (first == std::string::npos) ? std::string() : str_.substr(first, last-first+1);
+}
+
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+        for (size_t i=0; i<size; ++i) write(buffer[i]);
+        return size;
+}
+
+
+size_t Print::write(const char *c_str)
+{
+        return write((const uint8_t *)c_str, strlen(c_str));
+}
+
+
+unsigned long millis()
+{
+        return gNowMs_;
+}
+
+
+unsigned long micros()
+{
+        return gNowMs_*1000UL;
+}
+
+
+void delay(const unsigned long ms)
+{
+        gNowMs_ += ms;
+}
+
+
+void advanceMillis(const unsigned long ms)
+{
+        gNowMs_ += ms;
+}
+
+
+void digitalWrite(const int pin, const int value)
+{
+        if (gDigitalWriteHook_) gDigitalWriteHook_(pin, value);
+}
+
+
+void setDigitalWriteHook(void (*hook)(int pin, int value))
+{
+        gDigitalWriteHook_ = hook;
+}
@@ -0,0 +1,112 @@
+/*
+ * Arduino.h
+ * 
+ * Minimal Arduino core for running ISBD.cc on a Linux host (test only).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define HIGH    1
+#define LOW     0
+#define DEC     10
+
+typedef uint8_t byte;
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+
+/**
+ * Subset of the Arduino String used by the library
+ */
+class String {
+public:
+        String(const char *c_str = "")                  : str_(c_str) {}
+        String(const __FlashStringHelper *c_str)        : str_(reinterpret_cast<const char *>(c_str)) {}
+        String(const std::string &str)                  : str_(str) {}
+        explicit String(char c)                         : str_(1, c) {}
+        String(int value, int base = DEC)               : str_(std::to_string(value)) { (void)base; }
+        String(unsigned int value, int base = DEC)      : str_(std::to_string(value)) { (void)base; }
+        String(long value, int base = DEC)              : str_(std::to_string(value)) { (void)base; }
+        String(unsigned long value, int base = DEC)     : str_(std::to_string(value)) { (void)base; }
+        String(double value, int decimals = 2);
+
+        unsigned int length() const                     { return str_.size(); }
+        const char*  c_str() const                      { return str_.c_str(); }
+        char         charAt(unsigned int i) const       { return str_[i]; }
+        char         operator[](unsigned int i) const   { return str_[i]; }
+        long         toInt() const                      { return atol(str_.c_str()); }
+        bool         reserve(unsigned int size)         { str_.reserve(size); return true; }
+        int          compareTo(const String &s) const   { return str_.compare(s.str_); }
+        bool         startsWith(const String &s) const  { return str_.compare(0, s.str_.size(), s.str_) == 0; }
+        bool         endsWith(const String &s) const;
+        int          indexOf(char c, unsigned int from = 0) const;
+        int          indexOf(const String &s, unsigned int from = 0) const;
+        String       substring(unsigned int from) const;
+        String       substring(unsigned int from, unsigned int to) const;
+        void         remove(unsigned int index, unsigned int count) { str_.erase(index, count); }
+        void         trim();
+
+        String& operator+=(const String &s)             { str_ += s.str_; return *this; }
+        String& operator+=(const char *c_str)           { str_ += c_str; return *this; }
+        String& operator+=(char c)                      { str_ += c; return *this; }
+        bool    operator==(const String &s) const       { return str_ == s.str_; }
+        bool    operator!=(const String &s) const       { return str_ != s.str_; }
+        friend String operator+(const String &a, const String &b) { return String(a.str_ + b.str_); }
+        friend String operator+(const String &a, const char *b)   { return String(a.str_ + b); }
+        friend String operator+(const String &a, char b)          { return String(a.str_ + b); }
+        friend String operator+(const String &a, int b)           { return String(a.str_ + std::to_string(b)); }
+        friend String operator+(const String &a, long b)          { return String(a.str_ + std::to_string(b)); }
+        friend String operator+(const String &a, unsigned long b) { return String(a.str_ + std::to_string(b)); }
+
+private:
+        std::string str_;
+};
+
+
+/**
+ * Virtual time: delay() advances the clock without sleeping, streams advance
+ * it while they wait for data.
+ */
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void advanceMillis(unsigned long ms);
+
+/**
+ * Pin writes are forwarded to a hook, e.g. to power a simulated modem
+ */
+void digitalWrite(int pin, int value);
+void setDigitalWriteHook(void (*hook)(int pin, int value));
+
+#endif
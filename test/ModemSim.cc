@@ -0,0 +1,344 @@
+/*
+ * ModemSim.cc
+ * 
+ * Scripted Iridium 9602/9603 modem on a pseudo-terminal (test only).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "ModemSim.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define MODEM_SIM_POLL_MS       1       //[ms] Real time to wait for data
+#define MODEM_SIM_TICK_MS       10      //[ms] Virtual time per poll without data
+
+struct BaudRateSpeed {
+        long    baud_rate;
+        speed_t speed;
+};
+
+static const BaudRateSpeed gBaudRateSpeeds_[] = {
+        {600, B600}, {1200, B1200}, {2400, B2400}, {4800, B4800}, {9600, B9600},
+        {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200}
+};
+static const int gIprBaudRates_[] = {0, 600, 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+
+
+ModemSim::ModemSim()
+{
+        masterFd_         = -1;
+        slaveFd_          = -1;
+        isRunning_        = false;
+        isPowered_        = false;
+        baudRate_         = MODEM_SIM_DEFAULT_BAUDRATE;
+        deafBaudRate_     = 0;
+        isFlowControl_    = true;
+        isSessionError_   = false;
+        binaryBytesLeft_  = 0;
+        numBytesReceived_ = 0;
+}
+
+
+ModemSim::~ModemSim()
+{
+        end();
+}
+
+
+bool ModemSim::begin()
+{
+        masterFd_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (masterFd_ < 0 || grantpt(masterFd_) != 0 || unlockpt(masterFd_) != 0) return false;
+        slaveFd_ = open(ptsname(masterFd_), O_RDWR | O_NOCTTY);
+        if (slaveFd_ < 0) return false;
+        struct termios tio;
+        tcgetattr(slaveFd_, &tio);
+        cfmakeraw(&tio);                                                // No echo, no CR/LF translation
+        tcsetattr(slaveFd_, TCSANOW, &tio);
+        setHostBaudRate(slaveFd_, MODEM_SIM_DEFAULT_BAUDRATE);
+        isRunning_ = true;
+        thread_ = std::thread(&ModemSim::run, this);
+        return true;
+}
+
+
+void ModemSim::end()
+{
+        isRunning_ = false;
+        if (thread_.joinable()) thread_.join();
+        if (slaveFd_  >= 0) close(slaveFd_);
+        if (masterFd_ >= 0) close(masterFd_);
+        slaveFd_  = -1;
+        masterFd_ = -1;
+}
+
+
+/**
+ * Power down resets the modem to its power up defaults
+ */
+void ModemSim::setPower(const bool is_on)
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (isPowered_ && !is_on) {
+                int num_pending = 0;                                    // Bytes in flight are lost, count them for PtyStream::flush()
+                ioctl(masterFd_, FIONREAD, &num_pending);
+                numBytesReceived_ += num_pending;
+                tcflush(masterFd_, TCIFLUSH);
+                tcflush(slaveFd_,  TCIFLUSH);
+                baudRate_        = MODEM_SIM_DEFAULT_BAUDRATE;
+                isFlowControl_   = true;
+                binaryBytesLeft_ = 0;
+                line_.clear();
+        }
+        isPowered_ = is_on;
+}
+
+
+void ModemSim::setDeafBaudRate(const long baud_rate)
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        deafBaudRate_ = baud_rate;
+}
+
+
+void ModemSim::setIsSessionError(const bool is_session_error)
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        isSessionError_ = is_session_error;
+}
+
+
+long ModemSim::getBaudRate()
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        return baudRate_;
+}
+
+
+bool ModemSim::getIsPowered()
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        return isPowered_;
+}
+
+
+bool ModemSim::getIsFlowControl()
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        return isFlowControl_;
+}
+
+
+std::vector<std::string> ModemSim::getCommands()
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        return commands_;
+}
+
+
+void ModemSim::clearCommands()
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands_.clear();
+}
+
+
+size_t ModemSim::getNumBytesReceived()
+{
+        std::lock_guard<std::mutex> lock(mutex_);
+        return numBytesReceived_;
+}
+
+
+bool ModemSim::setHostBaudRate(const int fd, const long baud_rate)
+{
+        for (size_t i=0; i<sizeof(gBaudRateSpeeds_)/sizeof(gBaudRateSpeeds_[0]); ++i) {
+                if (gBaudRateSpeeds_[i].baud_rate != baud_rate) continue;
+                struct termios tio;
+                if (tcgetattr(fd, &tio) != 0) return false;
+                cfsetispeed(&tio, gBaudRateSpeeds_[i].speed);
+                cfsetospeed(&tio, gBaudRateSpeeds_[i].speed);
+                return tcsetattr(fd, TCSANOW, &tio) == 0;
+        }
+        return false;
+}
+
+
+void ModemSim::run()
+{
+        uint8_t buffer[256];
+        while (isRunning_) {
+                struct pollfd pfd = {masterFd_, POLLIN, 0};
+                if (poll(&pfd, 1, 10) <= 0) continue;
+                const ssize_t size = ::read(masterFd_, buffer, sizeof(buffer));
+                if (size <= 0) continue;
+                std::lock_guard<std::mutex> lock(mutex_);
+                receive(buffer, size);
+                numBytesReceived_ += size;                              // After handling, see PtyStream::flush()
+        }
+}
+
+
+void ModemSim::receive(const uint8_t *data, const size_t size)
+{
+        if (!isLinkUp()) return;                                        // Garbage at the wrong baudrate
+        for (size_t i=0; i<size; ++i) {
+                if (binaryBytesLeft_ > 0) {                             // AT+SBDWB payload and checksum
+                        moBuffer_.push_back(data[i]);
+                        if (--binaryBytesLeft_ > 0) continue;
+                        uint16_t checksum = 0;
+                        for (size_t j=0; j+2<moBuffer_.size(); ++j) checksum += moBuffer_[j];
+                        const uint16_t checksum_host = (moBuffer_[moBuffer_.size()-2] << 8) | moBuffer_.back();
+                        moBuffer_.resize(moBuffer_.size()-2);
+                        reply(checksum == checksum_host ? "0\r\n\r\nOK\r\n" : "2\r\n\r\nOK\r\n");
+                        continue;
+                }
+                if (data[i] != '\r') {
+                        line_ += (char)data[i];
+                        continue;
+                }
+                const std::string command = line_;
+                line_.clear();
+                if (command.compare(0, 2, "AT") != 0) continue;         // No answer without AT prefix
+                commands_.push_back(command);
+                handleCommand(command);
+        }
+}
+
+
+void ModemSim::handleCommand(const std::string &command)
+{
+        if (command == "AT&K0" || command == "AT&K3") {
+                isFlowControl_ = (command == "AT&K3");
+                reply("\r\nOK\r\n");
+        } else if (command.compare(0, 7, "AT+IPR=") == 0) {
+                const int ipr_code = atoi(command.c_str()+7);
+                if (ipr_code < 1 || ipr_code > 9) {
+                        reply("\r\nERROR\r\n");
+                        return;
+                }
+                reply("\r\nOK\r\n");                                    // Acknowledged with the old baudrate
+                baudRate_ = gIprBaudRates_[ipr_code];
+        } else if (command.compare(0, 9, "AT+SBDWB=") == 0) {
+                binaryBytesLeft_ = atoi(command.c_str()+9) + 2;
+                moBuffer_.clear();
+                reply("READY\r\n");
+        } else if (command == "AT+CSQF") {
+                reply("\r\n+CSQF:4\r\n\r\nOK\r\n");
+        } else if (command == "AT+SBDI") {                              // MO status 0 with empty MO buffer
+                const int mo_status = moBuffer_.empty() ? 0 : (isSessionError_ ? 2 : 1);
+                const int mt_status = isSessionError_ ? 2 : 0;
+                reply("\r\n+SBDI: " + std::to_string(mo_status) + ", 1, " + std::to_string(mt_status) + ", 0, 0, 0\r\n\r\nOK\r\n");
+        } else if (command == "AT+SBDD0" || command == "AT+SBDD2") {
+                moBuffer_.clear();
+                reply("\r\n0\r\n\r\nOK\r\n");
+        } else {
+                reply("\r\nOK\r\n");
+        }
+}
+
+
+void ModemSim::reply(const std::string &msg)
+{
+        if (!isLinkUp()) return;
+        if (::write(masterFd_, msg.data(), msg.size()) < 0) perror("ModemSim write");
+}
+
+
+long ModemSim::getHostBaudRate()
+{
+        struct termios tio;
+        if (tcgetattr(slaveFd_, &tio) != 0) return 0;
+        const speed_t speed = cfgetospeed(&tio);
+        for (size_t i=0; i<sizeof(gBaudRateSpeeds_)/sizeof(gBaudRateSpeeds_[0]); ++i) {
+                if (gBaudRateSpeeds_[i].speed == speed) return gBaudRateSpeeds_[i].baud_rate;
+        }
+        return 0;
+}
+
+
+bool ModemSim::isLinkUp()
+{
+        return isPowered_ && baudRate_ != deafBaudRate_ && baudRate_ == getHostBaudRate();
+}
+
+
+size_t PtyStream::write(const uint8_t c)
+{
+        if (::write(modem_.getHostFd(), &c, 1) != 1) return 0;
+        numBytesSent_++;
+        return 1;
+}
+
+
+void PtyStream::flush()
+{
+        while (modem_.getNumBytesReceived() < numBytesSent_) usleep(100);
+}
+
+
+int PtyStream::available()
+{
+        int size = 0;
+        ioctl(modem_.getHostFd(), FIONREAD, &size);
+        if (size == 0 && peek_ < 0) {
+                struct pollfd pfd = {modem_.getHostFd(), POLLIN, 0};
+                poll(&pfd, 1, MODEM_SIM_POLL_MS);
+                advanceMillis(MODEM_SIM_TICK_MS);
+        }
+        return size + (peek_ >= 0 ? 1 : 0);
+}
+
+
+int PtyStream::read()
+{
+        const int c = peek();
+        peek_ = -1;
+        return c;
+}
+
+
+int PtyStream::peek()
+{
+        if (peek_ >= 0) return peek_;
+        struct pollfd pfd = {modem_.getHostFd(), POLLIN, 0};
+        if (poll(&pfd, 1, 0) <= 0) return -1;
+        uint8_t c;
+        if (::read(modem_.getHostFd(), &c, 1) != 1) return -1;
+        peek_ = c;
+        return peek_;
+}
+
+
+size_t NullStream::write(const uint8_t c)
+{
+        if (isVerbose_) putchar(c);
+        return 1;
+}
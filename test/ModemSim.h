@@ -0,0 +1,131 @@
+/*
+ * ModemSim.h
+ * 
+ * Scripted Iridium 9602/9603 modem on a pseudo-terminal. The host side of the
+ * pty is a PtyStream that ISBD.cc talks to, the modem side answers the AT
+ * commands the library uses. Both sides have a baudrate: the host baudrate is
+ * the termios speed of the pty, the modem baudrate follows AT+IPR and resets
+ * to 19200 on power down. Bytes sent while the two do not match are lost.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef MODEM_SIM_H
+#define MODEM_SIM_H
+
+#include "Arduino.h"
+#include "Stream.h"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define MODEM_SIM_DEFAULT_BAUDRATE      19200
+
+
+class ModemSim {
+public:
+        ModemSim();
+        ~ModemSim();
+        bool begin();
+        void end();
+
+        void setPower(bool is_on);
+        void setDeafBaudRate(long baud_rate);           // Modem accepts AT+IPR for it, but does not answer anymore
+        void setIsSessionError(bool is_session_error);  // AT+SBDI fails with MO and MT status 2
+        long getBaudRate();
+        bool getIsPowered();
+        bool getIsFlowControl();
+        std::vector<std::string> getCommands();
+        void clearCommands();
+
+        int    getHostFd() const                        { return slaveFd_; }
+        size_t getNumBytesReceived();
+        static bool setHostBaudRate(int fd, long baud_rate);
+
+private:
+        void run();
+        void receive(const uint8_t *data, size_t size);
+        void handleCommand(const std::string &command);
+        void reply(const std::string &msg);
+        long getHostBaudRate();
+        bool isLinkUp();
+
+        int             masterFd_;
+        int             slaveFd_;
+        std::thread     thread_;
+        volatile bool   isRunning_;
+        std::mutex      mutex_;
+
+        bool            isPowered_;
+        long            baudRate_;
+        long            deafBaudRate_;
+        bool            isFlowControl_;
+        bool            isSessionError_;
+        std::string     line_;
+        size_t          binaryBytesLeft_;
+        std::vector<uint8_t> moBuffer_;
+        std::vector<std::string> commands_;
+        size_t          numBytesReceived_;
+};
+
+
+/**
+ * Host end of the pty as Arduino Stream. Waiting for data advances the
+ * virtual clock, flush() returns when the modem has handled all bytes.
+ */
+class PtyStream : public Stream {
+public:
+        PtyStream(ModemSim &modem) : modem_(modem), numBytesSent_(0), peek_(-1) {}
+        size_t write(uint8_t c) override;
+        using Print::write;
+        void   flush() override;
+        int    available() override;
+        int    read() override;
+        int    peek() override;
+
+private:
+        ModemSim&       modem_;
+        size_t          numBytesSent_;
+        int             peek_;
+};
+
+
+/**
+ * Console that drops all output, or prints it when verbose
+ */
+class NullStream : public Stream {
+public:
+        NullStream(bool is_verbose = false) : isVerbose_(is_verbose) {}
+        size_t write(uint8_t c) override;
+        using Print::write;
+        int    available() override                     { return 0; }
+        int    read() override                          { return -1; }
+        int    peek() override                          { return -1; }
+
+private:
+        bool isVerbose_;
+};
+
+#endif
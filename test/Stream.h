@@ -0,0 +1,58 @@
+/*
+ * Stream.h
+ * 
+ * Minimal Arduino Print/Stream for running ISBD.cc on a Linux host (test only).
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "Arduino.h"
+
+
+class Print {
+public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size);
+        virtual void   flush() {}
+        size_t write(const char *c_str);
+        size_t print(const String &s)                   { return write(s.c_str()); }
+        size_t print(const char *c_str)                 { return write(c_str); }
+        size_t print(const __FlashStringHelper *c_str)  { return write(reinterpret_cast<const char *>(c_str)); }
+        size_t print(long value, int base = DEC)        { return print(String(value, base)); }
+        size_t println(const String &s)                 { return print(s) + write("\r\n"); }
+};
+
+
+class Stream : public Print {
+public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+};
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * test_isbd.cc
+ * 
+ * Runs ISBD.cc against the pty modem simulator. Returns the number of
+ * failed checks.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "ModemSim.h"
+#include "../ISBD.h"
+#include <algorithm>
+#include <stdio.h>
+
+#define POWER_PIN       12
+#define SLEEP_PIN       21
+
+static ModemSim gModem_;
+static int      gNumFailures_ = 0;
+static bool     gIsDeadAfterPowerDown_ = false;
+
+#define CHECK(condition) do { \
+                if (!(condition)) { \
+                        printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+                        gNumFailures_++; \
+                } \
+        } while (0)
+
+
+static void onDigitalWrite(const int pin, const int value)
+{
+        if (pin != POWER_PIN) return;
+        if (value == LOW && gIsDeadAfterPowerDown_) gModem_.setDeafBaudRate(ISBD_SERIAL_BAUDRATE);
+        gModem_.setPower(value == HIGH);
+}
+
+
+static void setHostBaudRate(const long baud_rate)
+{
+        ModemSim::setHostBaudRate(gModem_.getHostFd(), baud_rate);
+}
+
+
+static int countCommand(const std::string &command)
+{
+        const std::vector<std::string> commands = gModem_.getCommands();
+        return std::count(commands.begin(), commands.end(), command);
+}
+
+
+static void testFlowControl(ISBD &isbd)
+{
+        printf("Flow control\n");
+        isbd.setIsFlowControl(true);
+        CHECK(isbd.enableModem() == ISBD_SUCCESS);
+        CHECK(countCommand("AT&K3") == 1 && gModem_.getIsFlowControl());
+        isbd.disableModem();
+
+        gModem_.clearCommands();
+        isbd.setIsFlowControl(false);
+        CHECK(isbd.enableModem() == ISBD_SUCCESS);
+        CHECK(countCommand("AT&K0") == 1 && !gModem_.getIsFlowControl());
+        isbd.disableModem();
+}
+
+
+static void testBaudRateSwitch(ISBD &isbd)
+{
+        printf("Baudrate switch\n");
+        uint8_t msg[50] = {0};
+        gModem_.clearCommands();
+        CHECK(isbd.setBaudRate(57600) == ISBD_SUCCESS);
+        CHECK(isbd.sendBinaryMsg(msg, sizeof(msg)) == ISBD_SUCCESS);
+        CHECK(countCommand("AT+IPR=8") == 1);
+        CHECK(gModem_.getBaudRate() == 57600);
+        CHECK(isbd.getBaudRate() == 57600);
+
+        CHECK(isbd.setBaudRate(115200) == ISBD_SUCCESS);               // Switch while enabled
+        CHECK(isbd.enableModem() == ISBD_SUCCESS);
+        CHECK(gModem_.getBaudRate() == 115200);
+        CHECK(isbd.sendBinaryMsg(msg, sizeof(msg)) == ISBD_SUCCESS);
+        isbd.disableModem();
+        CHECK(gModem_.getBaudRate() == ISBD_SERIAL_BAUDRATE);           // Power down resets AT+IPR
+
+        CHECK(isbd.setBaudRate(ISBD_SERIAL_BAUDRATE) == ISBD_SUCCESS);
+}
+
+
+static void testBaudRateFallback(ISBD &isbd)
+{
+        printf("Baudrate fallback on power up\n");
+        uint8_t msg[50] = {0};
+        gModem_.setDeafBaudRate(57600);
+        gModem_.clearCommands();
+        CHECK(isbd.setBaudRate(57600) == ISBD_SUCCESS);
+        CHECK(isbd.sendBinaryMsg(msg, sizeof(msg)) == ISBD_SUCCESS);
+        CHECK(countCommand("AT+IPR=8") == 1);
+        CHECK(gModem_.getBaudRate() == ISBD_SERIAL_BAUDRATE);
+        CHECK(isbd.getBaudRate() == ISBD_SERIAL_BAUDRATE);
+
+        gModem_.clearCommands();                                        // Failure is remembered
+        CHECK(isbd.sendBinaryMsg(msg, sizeof(msg)) == ISBD_SUCCESS);
+        CHECK(countCommand("AT+IPR=8") == 0);
+
+        printf("Baudrate fallback while enabled\n");
+        CHECK(isbd.enableModem() == ISBD_SUCCESS);
+        CHECK(isbd.setBaudRate(57600) == ISBD_ERR_BAUDRATE);
+        CHECK(isbd.getBaudRate() == ISBD_SERIAL_BAUDRATE);
+        CHECK(gModem_.getBaudRate() == ISBD_SERIAL_BAUDRATE);
+        CHECK(isbd.sendBinaryMsg(msg, sizeof(msg)) == ISBD_SUCCESS);
+        isbd.disableModem();
+
+        printf("Baudrate fallback without modem after power cycle\n");
+        CHECK(isbd.enableModem() == ISBD_SUCCESS);
+        gIsDeadAfterPowerDown_ = true;
+        CHECK(isbd.setBaudRate(57600) == ISBD_ERR_BAUDRATE);
+        CHECK(!isbd.getModemIsEnabled());
+        CHECK(!gModem_.getIsPowered());
+        gIsDeadAfterPowerDown_ = false;
+        gModem_.setDeafBaudRate(0);
+
+        printf("Host baudrate function cleared after setBaudRate()\n");
+        CHECK(isbd.setBaudRate(57600) == ISBD_SUCCESS);
+        isbd.setHostBaudRateFunction(NULL);
+        CHECK(isbd.enableModem() == ISBD_SUCCESS);
+        CHECK(isbd.getBaudRate() == ISBD_SERIAL_BAUDRATE);
+        CHECK(gModem_.getBaudRate() == ISBD_SERIAL_BAUDRATE);
+        isbd.disableModem();
+        isbd.setHostBaudRateFunction(setHostBaudRate);
+}
+
+
+static int getNumSlotSuccesses(ISBD &isbd)
+{
+        ISBDSessionHistory history;
+        isbd.exportSessionHistory((uint8_t *)&history, sizeof(history));
+        int num_successes = 0;
+        for (int slot=0; slot<ISBD_HISTORY_NUM_SLOTS; ++slot) num_successes += history.slot_successes[slot];
+        return num_successes;
+}
+
+
+static ISBDSession getLastSession(ISBD &isbd)
+{
+        ISBDSessionHistory history;
+        isbd.exportSessionHistory((uint8_t *)&history, sizeof(history));
+        return history.sessions[(history.next + ISBD_HISTORY_SIZE - 1) % ISBD_HISTORY_SIZE];
+}
+
+
+static void testSessionHistory(ISBD &isbd)
+{
+        printf("Session history of mailbox checks\n");
+        ISBDSessionHistory empty_history = {};                          // Many failed attempts halve older counters
+        CHECK(isbd.importSessionHistory((const uint8_t *)&empty_history, sizeof(empty_history)));
+        gModem_.setIsSessionError(true);                                // Empty MO buffer: MO status 0, MT status 2
+        CHECK(isbd.receiveMsgs(10000) == ISBD_ERR_DEADLINE);            // Retries until the deadline
+        CHECK(getNumSlotSuccesses(isbd) == 0);
+        CHECK(getLastSession(isbd).mo_status == 0 && getLastSession(isbd).mt_status == 2);
+        CHECK(getLastSession(isbd).signal == 4);                        // +CSQF:4 of the simulator, not an SBDI answer
+        isbd.setTransmissionTimeoutSec(5);
+        CHECK(isbd.receiveMsgs() == ISBD_ERR_SENDRECEIVE_TIMEOUT);      // Retries until the transmission timeout
+        CHECK(getNumSlotSuccesses(isbd) == 0);
+        isbd.setTransmissionTimeoutSec(ISBD_DEFAULT_TRANSMISSION_TIMEOUT_SEC);
+        gModem_.setIsSessionError(false);
+        CHECK(isbd.receiveMsgs() == ISBD_SUCCESS);
+        CHECK(getNumSlotSuccesses(isbd) == 1);
+        CHECK(getLastSession(isbd).mo_status == 0 && getLastSession(isbd).mt_status == 0);
+        isbd.disableModem();
+}
+
+
+int main(int argc, char *[])
+{
+        if (!gModem_.begin()) {
+                perror("Can not open pty");
+                return 1;
+        }
+        setDigitalWriteHook(onDigitalWrite);
+        PtyStream  modem_stream(gModem_);
+        NullStream console_stream(argc > 1);                            // Any argument prints the library console
+        {
+                ISBD isbd(modem_stream, console_stream, POWER_PIN, SLEEP_PIN);
+                isbd.setIsConsolePrint(true);
+                isbd.setHostBaudRateFunction(setHostBaudRate);
+                testFlowControl(isbd);
+                testBaudRateSwitch(isbd);
+                testBaudRateFallback(isbd);
+                testSessionHistory(isbd);
+        }
+        gModem_.end();
+        printf("%d failed\n", gNumFailures_);
+        return gNumFailures_;
+}
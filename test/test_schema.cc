@@ -0,0 +1,90 @@
+/*
+ * test_schema.cc
+ * 
+ * Encodes and decodes ISBDSchema messages on the host. Returns the number of
+ * failed checks.
+ * 
+ * Copyright (c) 2018 Jari Kruetzfeldt, Jakob Kuttenkeuler
+ * 
+ * MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "../server/Telemetry.h"
+#include <stdio.h>
+
+static int gNumFailures_ = 0;
+
+#define CHECK(condition) do { \
+                if (!(condition)) { \
+                        printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+                        gNumFailures_++; \
+                } \
+        } while (0)
+
+
+static void testExactDecode()
+{
+        printf("Exact decode of wide fields\n");
+        uint8_t msg[Telemetry::size];
+        Telemetry::encode(msg, 1760812345UL, 59.34567, -18.07123, 21.5, 3.71, 45);
+        double values[Telemetry::num_fields];
+        CHECK(Telemetry::decode(msg, sizeof(msg), values));
+        CHECK(values[0] == 1760812345.0);
+        CHECK(values[1] == 5934567/100000.0);
+        CHECK(values[2] == -1807123/100000.0);
+        CHECK(values[5] == 45.0);
+
+        float float_values[Telemetry::num_fields];                      // Float still decodes narrow fields
+        CHECK(Telemetry::decode(msg, sizeof(msg), float_values));
+        CHECK(float_values[3] == 21.5f);
+        CHECK(float_values[5] == 45.0f);
+        CHECK(!Telemetry::decode(msg, sizeof(msg)-1, values));
+}
+
+
+static void testFullWidth()
+{
+        printf("32 bit fields\n");
+        typedef ISBDSchema< ISBDField<32, 0, 4294967295LL>,
+                            ISBDField<32, -2147483648LL, 2147483647L> >
+                Wide;
+        uint8_t msg[Wide::size];
+        Wide::encode(msg, 4294967295ULL, -2147483647L-1);
+        double values[Wide::num_fields];
+        CHECK(Wide::decode(msg, sizeof(msg), values));
+        CHECK(values[0] == 4294967295.0);
+        CHECK(values[1] == -2147483648.0);
+
+        Wide::encode(msg, 4000000000.0, 0.0);                           // Double input keeps its precision
+        CHECK(Wide::decode(msg, sizeof(msg), values));
+        CHECK(values[0] == 4000000000.0);
+        CHECK(values[1] == 0.0);
+}
+
+
+int main()
+{
+        testExactDecode();
+        testFullWidth();
+        printf("%d failed\n", gNumFailures_);
+        return gNumFailures_;
+}
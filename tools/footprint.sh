@@ -0,0 +1,113 @@
+#!/bin/sh
+#
+# footprint.sh
+#
+# Report flash, static RAM and stack use of the ISBD library for one board
+# and one capacity configuration. Needs arduino-cli with the board core
+# installed.
+#
+# Usage:   tools/footprint.sh <fqbn> [-DISBD_...]...
+# Example: tools/footprint.sh arduino:sam:arduino_due_x_dbg
+#          tools/footprint.sh arduino:avr:mega -DISBD_NO_CONSOLE -DISBD_MT_BUFFER_SIZE=64 -DISBD_HISTORY_SIZE=8
+#
+# Flash and static RAM are taken from arduino-cli for a sketch that uses all
+# main functions with one global ISBD instance. Stack is reported per
+# function (-fstack-usage) and summed along the deepest call chains of the
+# library (CHAINS below); the peak is the largest sum. A function listed
+# twice (recursion, overloads calling each other) counts twice, functions
+# inlined by the compiler count 0. Stack of Stream/String calls and of your
+# message handlers comes on top. Heap use is bounded by
+# ISBD_RESPONSE_BUFFER_SIZE plus the String messages passed in.
+#
+
+set -e
+
+CHAINS="sendBinaryMsg sendBinaryMsgImpl connectToSatellites waitForModemResponse console
+sendBinaryMsg sendBinaryMsgImpl connectToSatellites getSignalQuality waitForModemResponse console
+sendBinaryMsg sendBinaryMsgImpl enableModem enableModemImpl modemPowerUp modemPowerUp getSbdAttention waitForModemResponse waitForModemResponse console
+sendBinaryMsg sendBinaryMsgImpl enableModem enableModemImpl modemPowerUp switchModemBaudRate getSbdAttention waitForModemResponse waitForModemResponse console
+sendBinaryMsg sendBinaryMsgImpl dispatchIncomingMsg getIncomingMsgFromModem waitForModemResponse waitForModemResponse console
+receiveMsgs receiveMsgsImpl dispatchIncomingMsg getIncomingMsgFromModem waitForModemResponse waitForModemResponse console"
+
+if [ $# -lt 1 ]; then
+        echo "Usage: $0 <fqbn> [-DISBD_...]..." >&2
+        exit 1
+fi
+
+FQBN="$1"
+shift
+DEFINES="$*"
+LIBRARY_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+mkdir -p "$WORK_DIR/footprint"
+cat > "$WORK_DIR/footprint/footprint.ino" <<'EOF'
+#include <ISBD.h>
+
+ISBD isbd(Serial1, Serial, 12, 21);
+
+void handler(const uint8_t *payload, size_t payload_size) {}
+
+void setup()
+{
+        String  msg_out = "footprint";
+        String  msg_in  = "";
+        int     num_msg_in = 0;
+        uint8_t bin_msg[ISBD_BIN_MAX_TX_MSG_SIZE] = {0};
+        isbd.setMsgHandler(0x01, handler);
+        isbd.getNetworkStatus();
+        isbd.sendTextMsg(msg_out);
+        isbd.sendReceiveTxtMsg(msg_out, msg_in, num_msg_in);
+        isbd.sendBinaryMsg(bin_msg, sizeof(bin_msg));
+        isbd.receiveMsgs();
+        isbd.disableModem();
+}
+
+void loop()
+{
+}
+EOF
+
+echo "Board:         $FQBN"
+echo "Configuration: ${DEFINES:-default}"
+echo
+
+arduino-cli compile \
+        --fqbn "$FQBN" \
+        --library "$LIBRARY_DIR" \
+        --build-path "$WORK_DIR/build" \
+        --build-property "compiler.cpp.extra_flags=-fstack-usage $DEFINES" \
+        "$WORK_DIR/footprint" | grep -E "^(Sketch uses|Global variables)"
+
+find "$WORK_DIR/build" -name "ISBD*.su" -exec cat {} + > "$WORK_DIR/stack.su"
+
+echo
+echo "Stack per function [byte] (largest first):"
+awk -F '\t' '{ sub(/^[^:]*:[^:]*:[^:]*:/, "", $1); printf "%8d  %s (%s)\n", $2, $1, $3 }' "$WORK_DIR/stack.su" \
+        | sort -rn \
+        | head -n 20
+
+echo
+echo "Stack per call chain [byte] (largest of all overloads per function):"
+echo "$CHAINS" | awk -F '\t' '
+        NR == FNR {
+                if (match($1, /ISBD::[A-Za-z0-9_]+\(/)) {
+                        name = substr($1, RSTART+6, RLENGTH-7)
+                        if ($2 > stack[name]) stack[name] = $2
+                }
+                next
+        }
+        {
+                n = split($0, chain, " ")
+                sum = 0
+                line = ""
+                for (i=1; i<=n; ++i) {
+                        sum += stack[chain[i]]
+                        line = line (i > 1 ? " > " : "") chain[i] "(" stack[chain[i]]+0 ")"
+                }
+                printf "%8d  %s\n", sum, line
+                if (sum > peak) peak = sum
+        }
+        END { printf "%8d  Peak\n", peak }
+' "$WORK_DIR/stack.su" -